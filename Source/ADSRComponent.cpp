@@ -55,9 +55,9 @@ void ADSRComponent::paint (juce::Graphics& g)
 
 void ADSRComponent::resized()
 {
-    const auto startX = 0.6f;
+    const auto startX = 0.0f;
     const auto startY = 0.2f;
-    const auto dialWidth = 0.1f;
+    const auto dialWidth = 0.25f;
     const auto dialHeight = 0.75f;
 
     mAttackSlider.setBoundsRelative(startX, startY, dialWidth, dialHeight);
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    ContentHash.cpp
+    Created: 11 Jan 2025 10:02:55am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "ContentHash.h"
+
+namespace
+{
+    constexpr juce::uint64 fnvOffsetBasis = 0xcbf29ce484222325ull;
+    constexpr juce::uint64 fnvPrime = 0x100000001b3ull;
+
+    juce::uint64 addBytes(juce::uint64 hash, const void* data, size_t numBytes) noexcept
+    {
+        auto* bytes = static_cast<const juce::uint8*>(data);
+
+        for (size_t i = 0; i < numBytes; ++i)
+            hash = (hash ^ bytes[i]) * fnvPrime;
+
+        return hash;
+    }
+}
+
+juce::uint64 ContentHash::ofFile(const juce::File& file)
+{
+    juce::FileInputStream stream(file);
+
+    if (stream.failedToOpen())
+        return 0;
+
+    auto size = stream.getTotalLength();
+    auto hash = addBytes(fnvOffsetBasis, &size, sizeof(size));
+
+    juce::HeapBlock<char> buffer((size_t) bytesPerEnd);
+
+    auto addRange = [&](juce::int64 start, juce::int64 numBytes) {
+        stream.setPosition(start);
+        auto numRead = stream.read(buffer, (int) numBytes);
+        hash = addBytes(hash, buffer, (size_t) juce::jmax(0, numRead));
+    };
+
+    addRange(0, juce::jmin(size, bytesPerEnd));
+
+    // the tail, without going over bytes the head already covered
+    if (size > bytesPerEnd)
+        addRange(juce::jmax(bytesPerEnd, size - bytesPerEnd), juce::jmin(bytesPerEnd, size - bytesPerEnd));
+
+    // 0 means unreadable
+    return hash != 0 ? hash : 1;
+}
@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    ContentHash.h
+    Created: 11 Jan 2025 10:02:55am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    A fingerprint of what's in a file: a 64-bit FNV-1a hash of its size and of up
+    to bytesPerEnd bytes from each end. Reading a couple of megabytes keeps it
+    cheap for samples of any length, and it still changes when a file is
+    re-exported or replaced by another one with the same name, which the
+    modification time doesn't tell you once sessions move between machines.
+*/
+struct ContentHash
+{
+    static constexpr juce::int64 bytesPerEnd = 1 << 20;
+
+    /** Returns 0 if the file can't be read. Reads from disk, keep it off the audio thread. */
+    static juce::uint64 ofFile(const juce::File& file);
+};
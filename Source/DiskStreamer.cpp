@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+    DiskStreamer.cpp
+    Created: 9 Nov 2024 3:27:18pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "DiskStreamer.h"
+#include "StreamingVoice.h"
+
+DiskStreamer::Stream::Stream(RealtimeSemaphore& wake) : mWake(wake)
+{
+    mRing.clear();
+}
+
+void DiskStreamer::Stream::start(StreamingSound* sound)
+{
+    mSound.store(sound);
+    mFirstFrame = sound->getHeadLength();
+    mNumReady = 0;
+    mGeneration.fetch_add(1, std::memory_order_release);
+    mWake.signal();
+}
+
+void DiskStreamer::Stream::stop()
+{
+    mSound.store(nullptr);
+    mNumReady = 0;
+    mGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void DiskStreamer::Stream::beginRead()
+{
+    // until the disk thread has reset the ring for this note, its contents belong to the previous one
+    if (mReadyGeneration.load(std::memory_order_acquire) != mGeneration.load(std::memory_order_relaxed)) {
+        mNumReady = 0;
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    mFifo.prepareToRead(mFifo.getNumReady(), start1, size1, start2, size2);
+
+    mReadIndex = start1;
+    mNumReady = size1 + size2;
+}
+
+bool DiskStreamer::Stream::getFrame(juce::int64 frame, float& left, float& right) const noexcept
+{
+    auto offset = frame - mFirstFrame;
+
+    if (offset < 0 || offset >= mNumReady)
+        return false;
+
+    auto index = (mReadIndex + (int) offset) & (ringSize - 1);
+    left = mRing.getReadPointer(0)[index];
+    right = mRing.getReadPointer(1)[index];
+    return true;
+}
+
+void DiskStreamer::Stream::releaseBefore(juce::int64 frame)
+{
+    auto numToRelease = (int) juce::jlimit((juce::int64) 0, (juce::int64) mNumReady, frame - mFirstFrame);
+
+    if (numToRelease == 0)
+        return;
+
+    // the disk thread only writes whole chunks until the end, so it's only worth waking as the
+    // free space crosses one. Below that it isn't writing, so nothing else can move the space.
+    auto freeBefore = mFifo.getFreeSpace();
+    mFifo.finishedRead(numToRelease);
+
+    if (freeBefore < readChunkSize && mFifo.getFreeSpace() >= readChunkSize)
+        mWake.signal();
+
+    mFirstFrame += numToRelease;
+    mReadIndex = (mReadIndex + numToRelease) & (ringSize - 1);
+    mNumReady -= numToRelease;
+}
+
+//==============================================================================
+DiskStreamer::DiskStreamer() : juce::Thread("YellowRose disk streamer")
+{
+    mFormatManager.registerBasicFormats();
+    startThread(juce::Thread::Priority::high);
+}
+
+DiskStreamer::~DiskStreamer()
+{
+    signalThreadShouldExit();
+    mWake.signal();
+    stopThread(4000);
+}
+
+DiskStreamer::Stream* DiskStreamer::createStream()
+{
+    const NonRealtimeLock::ScopedLockType sl(mStreamLock);
+    return mStreams.add(new Stream(mWake));
+}
+
+void DiskStreamer::soundDeleted(const StreamingSound* sound)
+{
+    // always the reader lock first, the disk thread never holds both
+    const NonRealtimeLock::ScopedLockType rl(mReaderLock);
+    const NonRealtimeLock::ScopedLockType sl(mStreamLock);
+
+    for (auto* stream : mStreams) {
+        if (stream->mReaderSound == sound) {
+            stream->mReader.reset();
+            stream->mReaderSound = nullptr;
+            stream->mNextReadFrame = stream->mEndFrame = 0;
+        }
+    }
+}
+
+int DiskStreamer::getNumUnderruns() const
+{
+    const NonRealtimeLock::ScopedLockType sl(mStreamLock);
+
+    int total = 0;
+
+    for (auto* stream : mStreams)
+        total += stream->getNumUnderruns();
+
+    return total;
+}
+
+void DiskStreamer::run()
+{
+    while (!threadShouldExit()) {
+        bool didSomething = false;
+
+        // streams are only ever added, so the pointers stay good once the lock is dropped,
+        // and creating one doesn't have to wait for the disk
+        {
+            const NonRealtimeLock::ScopedLockType sl(mStreamLock);
+            mServicedStreams.clearQuick();
+            mServicedStreams.addArray(mStreams.begin(), mStreams.size());
+        }
+
+        for (auto* stream : mServicedStreams) {
+            const NonRealtimeLock::ScopedLockType rl(mReaderLock);
+            didSomething = service(*stream) || didSomething;
+        }
+
+        // a full pass with nothing to read means every ring is full or finished
+        if (!didSomething)
+            mWake.wait(-1);
+    }
+}
+
+bool DiskStreamer::service(Stream& stream)
+{
+    auto generation = stream.mGeneration.load(std::memory_order_acquire);
+
+    if (generation != stream.mServicedGeneration) {
+        auto* sound = stream.mSound.load();
+
+        stream.mFifo.reset();
+        stream.mServicedGeneration = generation;
+        stream.mNextReadFrame = stream.mEndFrame = 0;
+
+        if (sound != nullptr) {
+            if (stream.mReaderSound != sound) {
+                stream.mReader.reset(mFormatManager.createReaderFor(sound->getFile()));
+                stream.mReaderSound = sound;
+            }
+
+            stream.mNextReadFrame = sound->getHeadLength();
+            stream.mEndFrame = sound->getLength();
+        }
+
+        stream.mReadyGeneration.store(generation, std::memory_order_release);
+    }
+
+    if (stream.mReader == nullptr || stream.mNextReadFrame >= stream.mEndFrame)
+        return false;
+
+    auto numLeft = stream.mEndFrame - stream.mNextReadFrame;
+    auto numToRead = (int) juce::jmin((juce::int64) stream.mFifo.getFreeSpace(), numLeft);
+
+    // don't bother the disk for a handful of frames, unless it's the end of the file
+    if (numToRead < readChunkSize && numToRead < numLeft)
+        return false;
+
+    numToRead = juce::jmin(numToRead, readChunkSize);
+
+    int start1, size1, start2, size2;
+    stream.mFifo.prepareToWrite(numToRead, start1, size1, start2, size2);
+
+    auto numChannels = juce::jmin(2, (int) stream.mReader->numChannels);
+
+    for (auto [start, size] : { std::make_pair(start1, size1), std::make_pair(start2, size2) }) {
+        if (size <= 0)
+            continue;
+
+        float* dest[] = { stream.mRing.getWritePointer(0, start), stream.mRing.getWritePointer(1, start) };
+        stream.mReader->read(dest, numChannels, stream.mNextReadFrame, size);
+
+        if (numChannels == 1)
+            juce::FloatVectorOperations::copy(dest[1], dest[0], size);
+
+        stream.mNextReadFrame += size;
+    }
+
+    stream.mFifo.finishedWrite(size1 + size2);
+    return true;
+}
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    DiskStreamer.h
+    Created: 9 Nov 2024 3:27:18pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RealtimeGuard.h"
+#include "RealtimeSemaphore.h"
+
+class StreamingSound;
+
+//==============================================================================
+/*
+    Feeds streaming voices from disk. Every voice owns a Stream: a lock-free
+    single producer / single consumer ring that this thread keeps topped up from
+    the sound's file while the voice reads from it on the audio thread.
+
+    The thread sleeps until a stream is started or a voice has read far enough
+    to make room for another chunk, so a streamer with nothing to do costs nothing.
+*/
+class DiskStreamer  : private juce::Thread
+{
+public:
+    static constexpr int ringSize = 1 << 15;
+    static constexpr int readChunkSize = 4096;
+
+    class Stream
+    {
+    public:
+        explicit Stream(RealtimeSemaphore& wake);
+
+        //==============================================================================
+        // audio thread
+
+        /** Starts streaming the part of the sound that follows its preloaded head. */
+        void start(StreamingSound* sound);
+        void stop();
+
+        /** Takes a snapshot of what the ring currently holds for the playing note. */
+        void beginRead();
+
+        /** One past the last frame streamed in, as of beginRead(). */
+        juce::int64 getReadyEnd() const noexcept { return mFirstFrame + mNumReady; }
+
+        /** Returns false if the frame hasn't been streamed in yet. */
+        bool getFrame(juce::int64 frame, float& left, float& right) const noexcept;
+
+        /** Hands every frame before this one back to the disk thread, and wakes it
+            once there's room for a chunk.
+        */
+        void releaseBefore(juce::int64 frame);
+
+        void reportUnderrun() noexcept { ++mUnderruns; }
+        int getNumUnderruns() const noexcept { return mUnderruns.load(); }
+
+    private:
+        friend class DiskStreamer;
+
+        RealtimeSemaphore& mWake;
+        juce::AbstractFifo mFifo{ ringSize };
+        juce::AudioBuffer<float> mRing{ 2, ringSize };
+
+        std::atomic<StreamingSound*> mSound{ nullptr };
+        std::atomic<juce::uint32> mGeneration{ 0 };
+        std::atomic<juce::uint32> mReadyGeneration{ 0 };
+        std::atomic<int> mUnderruns{ 0 };
+
+        // audio thread only
+        juce::int64 mFirstFrame{ 0 };
+        int mReadIndex{ 0 };
+        int mNumReady{ 0 };
+
+        // disk thread only
+        juce::uint32 mServicedGeneration{ 0 };
+        std::unique_ptr<juce::AudioFormatReader> mReader;
+        const StreamingSound* mReaderSound{ nullptr };
+        juce::int64 mNextReadFrame{ 0 };
+        juce::int64 mEndFrame{ 0 };
+
+        JUCE_DECLARE_NON_COPYABLE (Stream)
+    };
+
+    DiskStreamer();
+    ~DiskStreamer() override;
+
+    /** Creates a stream for a new voice. Call this before playback starts. */
+    Stream* createStream();
+
+    /** Called from a sound's destructor so no stream keeps reading from it. */
+    void soundDeleted(const StreamingSound* sound);
+
+    /** Total number of blocks in which a voice ran out of streamed data. */
+    int getNumUnderruns() const;
+
+private:
+    void run() override;
+    bool service(Stream& stream);
+
+    juce::AudioFormatManager mFormatManager;
+    juce::OwnedArray<Stream> mStreams;
+    NonRealtimeLock mStreamLock;
+
+    // held while a stream's reader is in use, so soundDeleted() can't pull it out from under a read
+    NonRealtimeLock mReaderLock;
+    RealtimeSemaphore mWake;
+
+    // disk thread only, the streams as of the last pass
+    juce::Array<Stream*> mServicedStreams;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DiskStreamer)
+};
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    Envelope.cpp
+    Created: 21 Dec 2024 12:09:33pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "Envelope.h"
+
+void Envelope::setSampleRate(double sampleRate) noexcept
+{
+    jassert(sampleRate > 0.0);
+    mSampleRate = sampleRate;
+    recalculateRates();
+}
+
+void Envelope::setParameters(const juce::ADSR::Parameters& parameters) noexcept
+{
+    mParameters = parameters;
+    recalculateRates();
+}
+
+void Envelope::recalculateRates() noexcept
+{
+    auto rateFor = [this](float distance, float seconds) {
+        return seconds > 0.0f ? (float) (distance / (seconds * mSampleRate)) : 0.0f;
+    };
+
+    mAttackRate = rateFor(1.0f, mParameters.attack);
+    mDecayRate = rateFor(1.0f - mParameters.sustain, mParameters.decay);
+    mSustainStep = (float) (1.0 / (sustainSmoothingSeconds * mSampleRate));
+
+    // a release that's already running keeps going from where it is, at the new speed
+    if (mState == State::release)
+        mReleaseRate = rateFor(mLevel, mParameters.release);
+}
+
+void Envelope::noteOn() noexcept
+{
+    mState = State::attack;
+}
+
+void Envelope::noteOff() noexcept
+{
+    if (mState == State::idle)
+        return;
+
+    mState = State::release;
+    mReleaseRate = mParameters.release > 0.0f ? (float) (mLevel / (mParameters.release * mSampleRate)) : 0.0f;
+}
+
+void Envelope::reset() noexcept
+{
+    mState = State::idle;
+    mLevel = 0.0f;
+}
+
+int Envelope::rampTowards(float* dest, int numSamples, float target, float step) noexcept
+{
+    auto distance = std::abs(target - mLevel);
+    auto numFrames = juce::jmin(numSamples, juce::jmax(1, (int) std::ceil(distance / step)));
+    auto signedStep = target > mLevel ? step : -step;
+
+    for (int i = 0; i < numFrames; ++i)
+        dest[i] = mLevel + signedStep * (float) (i + 1);
+
+    mLevel += signedStep * (float) numFrames;
+
+    // only the last frame can overshoot
+    if ((signedStep > 0.0f && mLevel >= target) || (signedStep < 0.0f && mLevel <= target)) {
+        mLevel = target;
+        dest[numFrames - 1] = target;
+    }
+
+    return numFrames;
+}
+
+int Envelope::getLinearFrames(float& step) const noexcept
+{
+    step = 0.0f;
+
+    // the frame that reaches the target is left out, getNextBlock() changes state on it
+    auto framesBefore = [this, &step](float target, float rate) {
+        step = target > mLevel ? rate : -rate;
+        return juce::jmax(0, (int) std::ceil(std::abs(target - mLevel) / rate) - 1);
+    };
+
+    switch (mState) {
+    case State::attack:
+        return mAttackRate > 0.0f ? framesBefore(1.0f, mAttackRate) : 0;
+
+    case State::decay:
+        return mDecayRate > 0.0f && mLevel > mParameters.sustain ? framesBefore(mParameters.sustain, mDecayRate) : 0;
+
+    case State::sustain:
+        if (mLevel != mParameters.sustain)
+            return framesBefore(mParameters.sustain, mSustainStep);
+
+        return std::numeric_limits<int>::max();
+
+    case State::release:
+        return mReleaseRate > 0.0f ? framesBefore(0.0f, mReleaseRate) : 0;
+
+    case State::idle:
+        break;
+    }
+
+    return 0;
+}
+
+void Envelope::getNextBlock(float* dest, int numSamples) noexcept
+{
+    int done = 0;
+
+    while (done < numSamples) {
+        auto* out = dest + done;
+        auto remaining = numSamples - done;
+
+        switch (mState) {
+        case State::idle:
+            juce::FloatVectorOperations::clear(out, remaining);
+            return;
+
+        case State::attack:
+            if (mAttackRate <= 0.0f)
+                mLevel = 1.0f;
+            else
+                done += rampTowards(out, remaining, 1.0f, mAttackRate);
+
+            if (mLevel >= 1.0f)
+                mState = State::decay;
+
+            break;
+
+        case State::decay:
+            if (mDecayRate <= 0.0f || mLevel <= mParameters.sustain)
+                mLevel = juce::jmin(mLevel, mParameters.sustain);
+            else
+                done += rampTowards(out, remaining, mParameters.sustain, mDecayRate);
+
+            if (mLevel <= mParameters.sustain)
+                mState = State::sustain;
+
+            break;
+
+        case State::sustain:
+            if (mLevel == mParameters.sustain) {
+                juce::FloatVectorOperations::fill(out, mLevel, remaining);
+                done = numSamples;
+            }
+            else {
+                done += rampTowards(out, remaining, mParameters.sustain, mSustainStep);
+            }
+
+            break;
+
+        case State::release:
+            if (mReleaseRate <= 0.0f)
+                mLevel = 0.0f;
+            else
+                done += rampTowards(out, remaining, 0.0f, mReleaseRate);
+
+            if (mLevel <= 0.0f) {
+                mLevel = 0.0f;
+                mState = State::idle;
+            }
+
+            break;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    Envelope.h
+    Created: 21 Dec 2024 12:09:33pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    A linear ADSR, like juce::ADSR, that renders a block at a time and accepts new
+    parameters while a note is playing.
+
+    Each segment is written as a plain ramp (start + step * i), which vectorises,
+    and the block is only split where a segment ends. A new sustain level is
+    reached over sustainSmoothingSeconds instead of jumping, so moving the
+    sustain control doesn't zipper.
+*/
+class Envelope
+{
+public:
+    static constexpr double sustainSmoothingSeconds = 0.02;
+
+    Envelope() = default;
+
+    void setSampleRate(double sampleRate) noexcept;
+
+    /** Takes effect straight away, including on a note that is already playing. */
+    void setParameters(const juce::ADSR::Parameters& parameters) noexcept;
+
+    void noteOn() noexcept;
+    void noteOff() noexcept;
+    void reset() noexcept;
+
+    bool isActive() const noexcept { return mState != State::idle; }
+    float getLevel() const noexcept { return mLevel; }
+
+    /** Writes the next numSamples envelope values. */
+    void getNextBlock(float* dest, int numSamples) noexcept;
+
+    /** How many of the next frames carry on in a straight line from the current level
+        without finishing a segment, and how much each one moves it by. Holding the
+        sustain level is a line that never ends. For code that renders the ramp itself,
+        see setRampLevel().
+    */
+    int getLinearFrames(float& step) const noexcept;
+
+    /** Takes up the level a ramp from getLinearFrames() was rendered to, at most that
+        many frames along it.
+    */
+    void setRampLevel(float level) noexcept { mLevel = level; }
+
+    /** For per-sample loops that may have to stop early. */
+    float getNextSample() noexcept
+    {
+        float value;
+        getNextBlock(&value, 1);
+        return value;
+    }
+
+private:
+    enum class State
+    {
+        idle,
+        attack,
+        decay,
+        sustain,
+        release
+    };
+
+    void recalculateRates() noexcept;
+
+    /** Writes a ramp from the current level, stopping at the target, returns the number of frames written. */
+    int rampTowards(float* dest, int numSamples, float target, float step) noexcept;
+
+    State mState{ State::idle };
+    float mLevel{ 0.0f };
+
+    juce::ADSR::Parameters mParameters;
+    double mSampleRate{ 44100.0 };
+
+    // per sample, zero means the segment is instant
+    float mAttackRate{ 0.0f }, mDecayRate{ 0.0f }, mReleaseRate{ 0.0f }, mSustainStep{ 0.0f };
+};
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    FilterComponent.cpp
+    Created: 15 Mar 2025 2:04:26pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "FilterComponent.h"
+
+void FilterComponent::makeSlider(juce::Slider& slider, juce::Label& label, const juce::String& labelText)
+{
+    slider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    slider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 40, 20);
+    slider.setColour(juce::Slider::ColourIds::rotarySliderFillColourId, juce::Colours::yellow);
+    slider.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::black);
+    label.setFont(10.0f);
+    label.setText(labelText, juce::NotificationType::dontSendNotification);
+    label.setJustificationType(juce::Justification::centredTop);
+    label.attachToComponent(&slider, false);
+}
+
+//==============================================================================
+FilterComponent::FilterComponent(YellowRoseAudioProcessor& p) : audioProcessor(p)
+{
+    mTypeBox.addItemList(VoiceFilter::getTypeNames(), 1);
+    mTypeBox.setTooltip("Filter type");
+    addAndMakeVisible(mTypeBox);
+    mTypeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getAPVTS(), "FILTERTYPE", mTypeBox);
+
+    const char* ids[numDials] = { "CUTOFF", "RESONANCE", "FILTERENV", "KEYTRACK", "FATTACK", "FDECAY", "FSUSTAIN", "FRELEASE" };
+    const char* names[numDials] = { "Cutoff", "Resonance", "Env Amount", "Key Track", "Attack", "Decay", "Sustain", "Release" };
+
+    for (int i = 0; i < numDials; ++i) {
+        makeSlider(mSliders[(size_t) i], mLabels[(size_t) i], names[i]);
+        addAndMakeVisible(mSliders[(size_t) i]);
+        mAttachments[(size_t) i] = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getAPVTS(), ids[i], mSliders[(size_t) i]);
+    }
+
+    mSliders[0].setTextValueSuffix(" Hz");
+}
+
+FilterComponent::~FilterComponent()
+{
+}
+
+void FilterComponent::paint (juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::grey);
+}
+
+void FilterComponent::resized()
+{
+    const auto startX = 0.2f;
+    const auto startY = 0.2f;
+    const auto dialWidth = 0.1f;
+    const auto dialHeight = 0.75f;
+
+    mTypeBox.setBoundsRelative(0.02f, 0.35f, 0.16f, 0.25f);
+
+    for (int i = 0; i < numDials; ++i)
+        mSliders[(size_t) i].setBoundsRelative(startX + i * dialWidth, startY, dialWidth, dialHeight);
+}
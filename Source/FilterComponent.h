@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    FilterComponent.h
+    Created: 15 Mar 2025 2:04:26pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/*
+    The filter type, the filter dials and the filter envelope.
+*/
+class FilterComponent  : public juce::Component
+{
+public:
+    FilterComponent(YellowRoseAudioProcessor& p);
+    ~FilterComponent() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    static constexpr int numDials = 8;
+
+    void makeSlider(juce::Slider& slider, juce::Label& label, const juce::String& labelText);
+
+    juce::ComboBox mTypeBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> mTypeAttachment;
+
+    // cutoff, resonance, envelope amount, key tracking, then the envelope
+    std::array<juce::Slider, numDials> mSliders;
+    std::array<juce::Label, numDials> mLabels;
+    std::array<std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>, numDials> mAttachments;
+
+    YellowRoseAudioProcessor& audioProcessor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilterComponent)
+};
@@ -0,0 +1,360 @@
+/*
+  ==============================================================================
+
+    Interpolator.cpp
+    Created: 30 Nov 2024 11:42:19am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "Interpolator.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64)
+ #include <arm_neon.h>
+ #define YELLOWROSE_NEON 1
+#endif
+
+namespace
+{
+    constexpr int halfTaps = Interpolator::sincTaps / 2;
+    constexpr int tableSize = (Interpolator::sincPhases + 1) * Interpolator::sincTaps;
+
+    // a touch below Nyquist so the windowed kernel doesn't pass images
+    constexpr double passband = 0.92;
+
+    // the first table is for steps up to 1, then one per quarter octave up, each cut off for
+    // the fastest step in its band. Past the last one the kernel is only a lobe or so wide in
+    // 16 taps, so a lower cutoff wouldn't filter any better.
+    constexpr int bandsPerOctave = 4;
+    constexpr int numSincBands = 1 + 3 * bandsPerOctave;
+
+    struct SincTables
+    {
+        // per band, one row of taps per phase, plus one so the last phase can be interpolated too
+        alignas(32) float taps[numSincBands][tableSize];
+
+        SincTables()
+        {
+            for (int band = 0; band < numSincBands; ++band)
+                build(taps[band], passband * std::exp2(-(double) band / bandsPerOctave));
+        }
+
+        static void build(float* table, double cutoff)
+        {
+            for (int phase = 0; phase <= Interpolator::sincPhases; ++phase) {
+                auto fraction = (double) phase / Interpolator::sincPhases;
+                auto* row = table + phase * Interpolator::sincTaps;
+                double sum = 0.0;
+
+                for (int tap = 0; tap < Interpolator::sincTaps; ++tap) {
+                    auto x = (double) (tap - (halfTaps - 1)) - fraction;
+                    auto sinc = x == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * cutoff * x)
+                                                   / (juce::MathConstants<double>::pi * cutoff * x);
+
+                    // Blackman-Harris over the kernel's span
+                    auto w = (x + halfTaps) / (2.0 * halfTaps) * juce::MathConstants<double>::twoPi;
+                    auto window = 0.35875 - 0.48829 * std::cos(w) + 0.14128 * std::cos(2.0 * w) - 0.01168 * std::cos(3.0 * w);
+
+                    row[tap] = (float) (sinc * window);
+                    sum += row[tap];
+                }
+
+                // unity gain at DC for every phase
+                for (int tap = 0; tap < Interpolator::sincTaps; ++tap)
+                    row[tap] = (float) (row[tap] / sum);
+            }
+        }
+    };
+
+    const SincTables& getSincTables()
+    {
+        static const SincTables tables;
+        return tables;
+    }
+
+    /** The kernel for a step, with the cutoff at or below the source's Nyquist over the step,
+        like Resampler's, so reading faster than the source doesn't fold what's above back down.
+    */
+    const float* getSincTable(double step) noexcept
+    {
+        auto band = step <= 1.0 ? 0 : juce::jmin(numSincBands - 1, (int) std::ceil(std::log2(step) * bandsPerOctave));
+        return getSincTables().taps[band];
+    }
+
+    //==============================================================================
+    // four floats in one SSE or NEON register, or in four plain floats elsewhere
+    struct Float4
+    {
+       #if JUCE_INTEL
+        __m128 v;
+
+        static Float4 load(const float* p) noexcept                   { return { _mm_loadu_ps(p) }; }
+        static Float4 set(float a, float b, float c, float d) noexcept { return { _mm_setr_ps(a, b, c, d) }; }
+        static Float4 fill(float x) noexcept                           { return { _mm_set1_ps(x) }; }
+        void store(float* p) const noexcept                             { _mm_storeu_ps(p, v); }
+
+        Float4 operator+(Float4 other) const noexcept { return { _mm_add_ps(v, other.v) }; }
+        Float4 operator-(Float4 other) const noexcept { return { _mm_sub_ps(v, other.v) }; }
+        Float4 operator*(Float4 other) const noexcept { return { _mm_mul_ps(v, other.v) }; }
+
+        float sum() const noexcept
+        {
+            auto pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+        }
+       #elif YELLOWROSE_NEON
+        float32x4_t v;
+
+        static Float4 load(const float* p) noexcept { return { vld1q_f32(p) }; }
+        static Float4 fill(float x) noexcept         { return { vdupq_n_f32(x) }; }
+        void store(float* p) const noexcept           { vst1q_f32(p, v); }
+
+        static Float4 set(float a, float b, float c, float d) noexcept
+        {
+            const float lanes[] = { a, b, c, d };
+            return load(lanes);
+        }
+
+        Float4 operator+(Float4 other) const noexcept { return { vaddq_f32(v, other.v) }; }
+        Float4 operator-(Float4 other) const noexcept { return { vsubq_f32(v, other.v) }; }
+        Float4 operator*(Float4 other) const noexcept { return { vmulq_f32(v, other.v) }; }
+
+        float sum() const noexcept
+        {
+          #if defined (__aarch64__) || defined (_M_ARM64)
+            return vaddvq_f32(v);
+          #else
+            auto pairs = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+            return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+          #endif
+        }
+       #else
+        float v[4];
+
+        static Float4 load(const float* p) noexcept                   { return { { p[0], p[1], p[2], p[3] } }; }
+        static Float4 set(float a, float b, float c, float d) noexcept { return { { a, b, c, d } }; }
+        static Float4 fill(float x) noexcept                           { return { { x, x, x, x } }; }
+        void store(float* p) const noexcept                             { std::copy(v, v + 4, p); }
+
+        Float4 operator+(Float4 other) const noexcept { return { { v[0] + other.v[0], v[1] + other.v[1], v[2] + other.v[2], v[3] + other.v[3] } }; }
+        Float4 operator-(Float4 other) const noexcept { return { { v[0] - other.v[0], v[1] - other.v[1], v[2] - other.v[2], v[3] - other.v[3] } }; }
+        Float4 operator*(Float4 other) const noexcept { return { { v[0] * other.v[0], v[1] * other.v[1], v[2] * other.v[2], v[3] * other.v[3] } }; }
+
+        float sum() const noexcept { return (v[0] + v[1]) + (v[2] + v[3]); }
+       #endif
+    };
+
+    static_assert(Interpolator::sincTaps % 4 == 0, "the sinc kernel is summed four taps at a time");
+
+    // where the next four output frames read from. The positions are worked out in double, so a
+    // long note doesn't drift, and only the fractions go to the float lanes.
+    struct FourFrames
+    {
+        int index[4];
+        float fraction[4];
+
+        FourFrames(double position, double step, int first) noexcept
+        {
+            for (int lane = 0; lane < 4; ++lane) {
+                auto pos = position + (first + lane) * step;
+                index[lane] = (int) pos;
+                fraction[lane] = (float) (pos - index[lane]);
+            }
+        }
+
+        // the sample lane by lane, offset frames from each lane's index
+        Float4 gather(const float* source, int offset) const noexcept
+        {
+            return Float4::set(source[index[0] + offset], source[index[1] + offset],
+                               source[index[2] + offset], source[index[3] + offset]);
+        }
+    };
+
+    //==============================================================================
+    float linearFrame(const float* source, double pos) noexcept
+    {
+        auto index = (int) pos;
+        auto alpha = (float) (pos - index);
+
+        return source[index] + alpha * (source[index + 1] - source[index]);
+    }
+
+    float cubicFrame(const float* source, double pos) noexcept
+    {
+        auto index = (int) pos;
+        auto t = (float) (pos - index);
+
+        auto xm1 = source[index - 1];
+        auto x0 = source[index];
+        auto x1 = source[index + 1];
+        auto x2 = source[index + 2];
+
+        auto c1 = 0.5f * (x1 - xm1);
+        auto c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+        auto c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+        return ((c3 * t + c2) * t + c1) * t + x0;
+    }
+
+    void processLinear(const float* source, double position, double step, float* dest, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4) {
+            FourFrames frames(position, step, i);
+
+            auto x0 = frames.gather(source, 0);
+            auto x1 = frames.gather(source, 1);
+
+            (x0 + Float4::load(frames.fraction) * (x1 - x0)).store(dest + i);
+        }
+
+        for (; i < numSamples; ++i)
+            dest[i] = linearFrame(source, position + i * step);
+    }
+
+    void processCubic(const float* source, double position, double step, float* dest, int numSamples) noexcept
+    {
+        const auto half = Float4::fill(0.5f);
+        const auto two = Float4::fill(2.0f);
+        const auto twoAndAHalf = Float4::fill(2.5f);
+        const auto oneAndAHalf = Float4::fill(1.5f);
+
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4) {
+            FourFrames frames(position, step, i);
+
+            auto xm1 = frames.gather(source, -1);
+            auto x0 = frames.gather(source, 0);
+            auto x1 = frames.gather(source, 1);
+            auto x2 = frames.gather(source, 2);
+            auto t = Float4::load(frames.fraction);
+
+            auto c1 = half * (x1 - xm1);
+            auto c2 = xm1 - twoAndAHalf * x0 + two * x1 - half * x2;
+            auto c3 = half * (x2 - xm1) + oneAndAHalf * (x0 - x1);
+
+            (((c3 * t + c2) * t + c1) * t + x0).store(dest + i);
+        }
+
+        for (; i < numSamples; ++i)
+            dest[i] = cubicFrame(source, position + i * step);
+    }
+
+    void processSinc(const float* source, double position, double step, float* dest, int numSamples) noexcept
+    {
+        const auto* table = getSincTable(step);
+
+        for (int i = 0; i < numSamples; ++i) {
+            auto pos = position + i * step;
+            auto index = (int) pos;
+            auto phasePosition = (float) (pos - index) * Interpolator::sincPhases;
+            auto phase = (int) phasePosition;
+            auto phaseAlpha = Float4::fill(phasePosition - (float) phase);
+
+            const auto* row0 = table + phase * Interpolator::sincTaps;
+            const auto* row1 = row0 + Interpolator::sincTaps;
+            const auto* input = source + index - (halfTaps - 1);
+
+            // the kernel is blended between the two phases first, so there's one dot product
+            // instead of two, four taps to a lane and added across the lanes at the end
+            auto sum = Float4::fill(0.0f);
+
+            for (int tap = 0; tap < Interpolator::sincTaps; tap += 4) {
+                auto taps0 = Float4::load(row0 + tap);
+                auto taps1 = Float4::load(row1 + tap);
+
+                sum = sum + (taps0 + phaseAlpha * (taps1 - taps0)) * Float4::load(input + tap);
+            }
+
+            dest[i] = sum.sum();
+        }
+    }
+}
+
+//==============================================================================
+void Interpolator::process(InterpolationMode mode, const float* source, double position, double step,
+                           float* dest, int numSamples) noexcept
+{
+    // the root key of a sample at the playback rate, every mode would only reproduce the frames
+    if (step == 1.0 && position == std::floor(position)) {
+        juce::FloatVectorOperations::copy(dest, source + (int) position, numSamples);
+        return;
+    }
+
+    switch (mode) {
+    case InterpolationMode::linear: processLinear(source, position, step, dest, numSamples); break;
+    case InterpolationMode::cubic:  processCubic(source, position, step, dest, numSamples); break;
+    case InterpolationMode::sinc:   processSinc(source, position, step, dest, numSamples); break;
+    }
+}
+
+void Interpolator::prepare()
+{
+    getSincTables();
+}
+
+double Interpolator::measureCost(InterpolationMode mode)
+{
+    constexpr int numFrames = 1 << 16;
+    constexpr int blockSize = 64;
+    constexpr int numRuns = 4;
+
+    juce::AudioBuffer<float> noise(1, numFrames);
+    juce::Random random(0x5eed);
+
+    for (int i = 0; i < numFrames; ++i)
+        noise.setSample(0, i, random.nextFloat() * 2.0f - 1.0f);
+
+    auto data = SampleData::fromBuffer("noise", noise, 44100.0);
+    auto view = data->getView();
+
+    // slightly sharp, so every fraction gets used
+    constexpr double step = 1.0097;
+    float dest[blockSize];
+
+    // keeps the optimiser from throwing the loops away
+    volatile float sink = 0.0f;
+
+    prepare();
+
+    auto best = std::numeric_limits<double>::max();
+
+    for (int run = 0; run < numRuns; ++run) {
+        int numRendered = 0;
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (double pos = 0.0; pos + blockSize * step < numFrames - 1; pos += blockSize * step) {
+            process(mode, view.getChannel(0), pos, step, dest, blockSize);
+            sink = sink + dest[0];
+            numRendered += blockSize;
+        }
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        best = juce::jmin(best, seconds * 1.0e9 / numRendered);
+    }
+
+    return best;
+}
+
+//==============================================================================
+InterpolationCosts::InterpolationCosts() : juce::Thread("YellowRose interpolation costs")
+{
+    startThread(juce::Thread::Priority::low);
+}
+
+InterpolationCosts::~InterpolationCosts()
+{
+    // one mode takes a few milliseconds, the run in progress is let finish
+    stopThread(1000);
+}
+
+void InterpolationCosts::run()
+{
+    for (int i = 0; i < Interpolator::numModes && !threadShouldExit(); ++i)
+        mCosts[(size_t) i].store(Interpolator::measureCost((InterpolationMode) i), std::memory_order_relaxed);
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    Interpolator.h
+    Created: 30 Nov 2024 11:42:19am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleData.h"
+
+enum class InterpolationMode
+{
+    linear = 0,
+    cubic,
+    sinc
+};
+
+//==============================================================================
+/*
+    Resamples one channel of a SampleData into a block. Each mode is a tight loop
+    without branches or bounds checks, it relies on the silence SampleData keeps
+    around its frames instead. Linear and cubic work out four output frames at a
+    time in SSE or NEON lanes, sinc sums its taps four to a lane.
+
+    Linear is two taps, cubic is a 4-point Hermite spline and sinc is a
+    Blackman-Harris windowed sinc with sincTaps taps. The sinc's cutoff follows
+    the step in quarter-octave bands, so a note played above its root doesn't alias.
+    Reading at a step of exactly one from a whole frame is a plain copy in every mode.
+*/
+struct Interpolator
+{
+    static constexpr int numModes = 3;
+    static constexpr int sincTaps = 16;
+    static constexpr int sincPhases = 256;
+
+    static_assert(sincTaps / 2 <= SampleData::paddingFrames, "the sinc kernel reads past the padding");
+
+    static juce::StringArray getModeNames() { return { "Linear", "Cubic", "Sinc" }; }
+
+    /** Writes numSamples frames, reading the source from position on in steps of step.
+        The source must be a channel of a SampleView and position must stay inside it.
+    */
+    static void process(InterpolationMode mode, const float* source, double position, double step,
+                        float* dest, int numSamples) noexcept;
+
+    /** Builds the sinc tables, so the first note played with them doesn't have to. */
+    static void prepare();
+
+    /** Times a mode on a synthetic sample and returns the cost in nanoseconds per
+        output frame and channel. Takes a few milliseconds, don't call it on the
+        audio thread.
+    */
+    static double measureCost(InterpolationMode mode);
+};
+
+//==============================================================================
+/*
+    The cost of every mode, measured once on a background thread when the first
+    of these is created. Share one through a juce::SharedResourcePointer, so
+    instances and repeated prepareToPlay calls don't measure again.
+*/
+class InterpolationCosts  : private juce::Thread
+{
+public:
+    InterpolationCosts();
+    ~InterpolationCosts() override;
+
+    /** In nanoseconds per output frame and channel, 0 until it has been measured.
+        Safe from any thread, the audio thread included.
+    */
+    double get(InterpolationMode mode) const noexcept { return mCosts[(size_t) mode].load(std::memory_order_relaxed); }
+
+private:
+    void run() override;
+
+    std::array<std::atomic<double>, Interpolator::numModes> mCosts{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InterpolationCosts)
+};
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    Keymap.cpp
+    Created: 4 Jan 2025 11:18:42am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "Keymap.h"
+
+Keymap::Keymap(std::vector<KeyZone> zones) : mZones(std::move(zones)), mTable(128 * 128, 0)
+{
+    // every cell's round-robins then come out in sequence order
+    std::stable_sort(mZones.begin(), mZones.end(), [](const KeyZone& a, const KeyZone& b) {
+        return a.sequencePosition < b.sequencePosition;
+    });
+
+    mCells.push_back({});
+
+    std::map<std::vector<int>, juce::uint16> cellsByZones;
+    std::vector<int> forNote, matching;
+
+    for (int note = 0; note < 128; ++note) {
+        forNote.clear();
+
+        for (int i = 0; i < (int) mZones.size(); ++i) {
+            if (mZones[(size_t) i].lowNote <= note && note <= mZones[(size_t) i].highNote)
+                forNote.push_back(i);
+        }
+
+        for (int velocity = 0; velocity < 128 && !forNote.empty(); ++velocity) {
+            matching.clear();
+
+            for (auto i : forNote) {
+                if (mZones[(size_t) i].lowVelocity <= velocity && velocity <= mZones[(size_t) i].highVelocity)
+                    matching.push_back(i);
+            }
+
+            if (matching.empty())
+                continue;
+
+            auto [it, isNew] = cellsByZones.emplace(matching, (juce::uint16) mCells.size());
+
+            if (isNew) {
+                Cell cell{ (int) mSteps.size(), 0, 0 };
+
+                // matching is in sequence order, so each position is one run
+                for (size_t i = 0; i < matching.size(); ++i) {
+                    auto& zone = mZones[(size_t) matching[i]];
+
+                    if (i == 0 || zone.sequencePosition != mZones[(size_t) matching[i - 1]].sequencePosition) {
+                        mSteps.push_back({ (int) mStepZones.size(), 0 });
+                        ++cell.numSteps;
+                    }
+
+                    mStepZones.push_back(&zone);
+                    ++mSteps.back().numZones;
+                }
+
+                mCells.push_back(cell);
+            }
+
+            mTable[(size_t) (note * 128 + velocity)] = it->second;
+            mMappedNotes[(size_t) note] = true;
+        }
+    }
+}
+
+Keymap::Ptr Keymap::forSample(SampleData::Ptr data, PeakPyramid::Ptr peaks, const juce::BigInteger& midiNotes, int rootNote)
+{
+    std::vector<KeyZone> zones(1);
+    auto& zone = zones.front();
+
+    zone.data = std::move(data);
+    zone.peaks = std::move(peaks);
+    zone.rootNote = rootNote;
+    zone.lowNote = juce::jmax(0, midiNotes.findNextSetBit(0));
+    zone.highNote = juce::jmin(127, midiNotes.getHighestBit());
+
+    return new Keymap(std::move(zones));
+}
+
+Keymap::Layers Keymap::findLayers(int midiNote, int velocity) noexcept
+{
+    auto& cell = mCells[mTable[(size_t) (juce::jlimit(0, 127, midiNote) * 128 + juce::jlimit(0, 127, velocity))]];
+
+    if (cell.numSteps == 0)
+        return {};
+
+    auto& step = mSteps[(size_t) (cell.firstStep + cell.next)];
+
+    if (++cell.next == cell.numSteps)
+        cell.next = 0;
+
+    return { mStepZones.data() + step.first, step.numZones };
+}
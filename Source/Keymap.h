@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    Keymap.h
+    Created: 4 Jan 2025 11:18:42am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleData.h"
+#include "PeakPyramid.h"
+#include "SampleLoop.h"
+
+//==============================================================================
+/** One sample and the notes and velocities it plays for. */
+struct KeyZone
+{
+    SampleData::Ptr data;
+    PeakPyramid::Ptr peaks;
+
+    int rootNote{ 60 };
+    int lowNote{ 0 }, highNote{ 127 };
+    int lowVelocity{ 0 }, highVelocity{ 127 };
+
+    /** Zones that overlap take turns, in order of their sequence position. Zones
+        with the same position play together, as layers.
+    */
+    int sequencePosition{ 1 };
+
+    float gain{ 1.0f };
+    double tuneSemitones{ 0.0 };
+
+    /** Null for a one-shot. */
+    SampleLoop::Ptr loop;
+
+    /** The stereo output the zone's notes play on, 0 being the main one. Outputs the
+        host hasn't enabled fall back to the main one.
+    */
+    int outputBus{ 0 };
+};
+
+//==============================================================================
+/*
+    Maps every (note, velocity) pair to the zones that can play it.
+
+    Everything is worked out when the keymap is built: pairs that share the same
+    set of zones share a cell, and a 128 x 128 table holds the cell for each pair.
+    A cell's zones are grouped into steps by sequence position. Finding the zones
+    for a note-on is a table read and a round-robin step.
+*/
+class Keymap  : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<Keymap>;
+
+    explicit Keymap(std::vector<KeyZone> zones);
+
+    /** One sample over a range of notes, like a plain SamplerSound. */
+    static Ptr forSample(SampleData::Ptr data, PeakPyramid::Ptr peaks, const juce::BigInteger& midiNotes, int rootNote);
+
+    /** The zones of one round-robin step, which all play at once. */
+    struct Layers
+    {
+        const KeyZone* const* zones{ nullptr };
+        int numZones{ 0 };
+
+        bool isEmpty() const noexcept { return numZones == 0; }
+        const KeyZone* const* begin() const noexcept { return zones; }
+        const KeyZone* const* end() const noexcept { return zones + numZones; }
+    };
+
+    /** Returns the zones at the cell's current step and moves the cell on to its next
+        one. Empty if nothing is mapped there. Audio thread only.
+    */
+    Layers findLayers(int midiNote, int velocity) noexcept;
+
+    bool hasZonesFor(int midiNote) const noexcept { return mMappedNotes[(size_t) juce::jlimit(0, 127, midiNote)]; }
+
+    const std::vector<KeyZone>& getZones() const noexcept { return mZones; }
+    int getNumCells() const noexcept { return (int) mCells.size() - 1; }
+
+private:
+    struct Step
+    {
+        int first{ 0 }, numZones{ 0 };
+    };
+
+    struct Cell
+    {
+        int firstStep{ 0 }, numSteps{ 0 };
+        int next{ 0 };
+    };
+
+    std::vector<KeyZone> mZones;
+
+    // each cell is a run of mSteps and each step a run of mStepZones, cell 0 is the empty one
+    std::vector<Cell> mCells;
+    std::vector<Step> mSteps;
+    std::vector<const KeyZone*> mStepZones;
+
+    std::vector<juce::uint16> mTable; // [note * 128 + velocity]
+    std::array<bool, 128> mMappedNotes{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Keymap)
+};
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    LoopComponent.cpp
+    Created: 8 Mar 2025 5:20:13pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "LoopComponent.h"
+
+void LoopComponent::makeSlider(juce::Slider& slider, juce::Label& label, const juce::String& labelText)
+{
+    slider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    slider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 40, 20);
+    slider.setColour(juce::Slider::ColourIds::rotarySliderFillColourId, juce::Colours::yellow);
+    slider.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::black);
+    label.setFont(10.0f);
+    label.setText(labelText, juce::NotificationType::dontSendNotification);
+    label.setJustificationType(juce::Justification::centredTop);
+    label.attachToComponent(&slider, false);
+}
+
+//==============================================================================
+LoopComponent::LoopComponent(YellowRoseAudioProcessor& p) : audioProcessor(p)
+{
+    mModeBox.addItemList(LoopSettings::getModeNames(), 1);
+    mModeBox.setTooltip("Loop mode");
+    addAndMakeVisible(mModeBox);
+    mModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getAPVTS(), "LOOPMODE", mModeBox);
+
+    makeSlider(mStartSlider, mStartLabel, "Loop Start");
+    addAndMakeVisible(mStartSlider);
+    mStartAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getAPVTS(), "LOOPSTART", mStartSlider);
+
+    makeSlider(mEndSlider, mEndLabel, "Loop End");
+    addAndMakeVisible(mEndSlider);
+    mEndAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getAPVTS(), "LOOPEND", mEndSlider);
+
+    makeSlider(mCrossfadeSlider, mCrossfadeLabel, "Crossfade");
+    mCrossfadeSlider.setTextValueSuffix(" ms");
+    addAndMakeVisible(mCrossfadeSlider);
+    mCrossfadeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getAPVTS(), "LOOPXFADE", mCrossfadeSlider);
+}
+
+LoopComponent::~LoopComponent()
+{
+}
+
+void LoopComponent::paint (juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::grey);
+}
+
+void LoopComponent::resized()
+{
+    const auto startX = 0.3f;
+    const auto startY = 0.2f;
+    const auto dialWidth = 0.2f;
+    const auto dialHeight = 0.75f;
+
+    mModeBox.setBoundsRelative(0.03f, 0.35f, 0.25f, 0.25f);
+    mStartSlider.setBoundsRelative(startX, startY, dialWidth, dialHeight);
+    mEndSlider.setBoundsRelative(startX + dialWidth, startY, dialWidth, dialHeight);
+    mCrossfadeSlider.setBoundsRelative(startX + 2 * dialWidth, startY, dialWidth, dialHeight);
+}
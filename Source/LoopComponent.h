@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    LoopComponent.h
+    Created: 8 Mar 2025 5:20:13pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/*
+    The loop mode and the loop start, end and crossfade dials.
+*/
+class LoopComponent  : public juce::Component
+{
+public:
+    LoopComponent(YellowRoseAudioProcessor& p);
+    ~LoopComponent() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void makeSlider(juce::Slider& slider, juce::Label& label, const juce::String& labelText);
+
+    juce::ComboBox mModeBox;
+    juce::Slider mStartSlider, mEndSlider, mCrossfadeSlider;
+    juce::Label mStartLabel, mEndLabel, mCrossfadeLabel;
+
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> mModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mStartAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mEndAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mCrossfadeAttachment;
+
+    YellowRoseAudioProcessor& audioProcessor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoopComponent)
+};
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    MidiBenchmark.cpp
+    Created: 28 Dec 2024 3:51:20pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "MidiBenchmark.h"
+#include "YellowRoseSynth.h"
+#include "SampleVoice.h"
+
+namespace
+{
+    constexpr int numVoices = 64;
+
+    std::unique_ptr<YellowRoseSynth> createSynth(juce::SynthesiserSound::Ptr sound, double sampleRate, int blockSize)
+    {
+        auto synth = std::make_unique<YellowRoseSynth>();
+
+        for (int i = 0; i < numVoices; ++i)
+            synth->addVoice(new SampleVoice());
+
+        synth->addSound(sound);
+        synth->prepare(sampleRate, blockSize);
+        synth->setPolyphony(numVoices);
+        return synth;
+    }
+}
+
+//==============================================================================
+juce::String MidiBenchmark::Result::toString() const
+{
+    auto line = [](const char* name, double ms, juce::int64 spans) {
+        return juce::String(name) + juce::String(ms, 2) + " ms, " + juce::String(spans) + " spans\n";
+    };
+
+    return juce::String(numEvents) + " events over " + juce::String(lengthSeconds, 1) + " s\n"
+         + line("stock:     ", stockMs, stockSpans)
+         + line("scheduled: ", scheduledMs, scheduledSpans)
+         + "speedup:   " + juce::String(scheduledMs > 0.0 ? stockMs / scheduledMs : 0.0, 2) + "x\n";
+}
+
+juce::MidiFile MidiBenchmark::createStressFile(double lengthSeconds)
+{
+    constexpr int ticksPerQuarter = 960;
+    constexpr int ticksPerSixteenth = ticksPerQuarter / 4;
+    constexpr int chord[] = { 48, 55, 60, 64, 67, 72 };
+
+    // 120 bpm, two quarters a second
+    auto numTicks = (int) (lengthSeconds * 2.0 * ticksPerQuarter);
+
+    juce::MidiMessageSequence track;
+    track.addEvent(juce::MidiMessage::tempoMetaEvent(500000), 0.0);
+
+    for (int tick = 0; tick < numTicks; ++tick) {
+        auto time = (double) tick;
+        auto phase = (double) tick / ticksPerQuarter * juce::MathConstants<double>::twoPi;
+
+        track.addEvent(juce::MidiMessage::pitchWheel(1, 8192 + (int) (4000.0 * std::sin(phase))), time);
+        track.addEvent(juce::MidiMessage::controllerEvent(1, 1, 64 + (int) (63.0 * std::sin(phase * 0.5))), time);
+        track.addEvent(juce::MidiMessage::controllerEvent(1, 11, 64 + (int) (63.0 * std::cos(phase * 0.25))), time);
+
+        if (tick % ticksPerSixteenth == 0) {
+            auto transpose = (tick / ticksPerQuarter) % 5;
+
+            for (auto note : chord) {
+                track.addEvent(juce::MidiMessage::noteOn(1, note + transpose, 0.8f), time);
+                track.addEvent(juce::MidiMessage::noteOff(1, note + transpose), time + ticksPerSixteenth - 1);
+            }
+        }
+    }
+
+    track.sort();
+
+    juce::MidiFile file;
+    file.setTicksPerQuarterNote(ticksPerQuarter);
+    file.addTrack(track);
+    return file;
+}
+
+MidiBenchmark::Result MidiBenchmark::run(const juce::MidiFile& file, double sampleRate, int blockSize, int controlInterval, int numRuns)
+{
+    Result result;
+
+    auto timed = file;
+    timed.convertTimestampTicksToSeconds();
+
+    juce::MidiMessageSequence sequence;
+
+    for (int i = 0; i < timed.getNumTracks(); ++i)
+        sequence.addSequence(*timed.getTrack(i), 0.0);
+
+    sequence.sort();
+
+    result.lengthSeconds = sequence.getEndTime();
+    result.numEvents = sequence.getNumEvents();
+
+    // cut into blocks up front so only the rendering is timed
+    auto numBlocks = (int) std::ceil(result.lengthSeconds * sampleRate / blockSize) + 1;
+    std::vector<juce::MidiBuffer> blocks((size_t) numBlocks);
+
+    for (auto* event : sequence) {
+        auto frame = juce::roundToInt(event->message.getTimeStamp() * sampleRate);
+        blocks[(size_t) juce::jmin(numBlocks - 1, frame / blockSize)].addEvent(event->message, frame % blockSize);
+    }
+
+    juce::AudioBuffer<float> sine(1, (int) sampleRate);
+
+    for (int i = 0; i < sine.getNumSamples(); ++i)
+        sine.setSample(0, i, 0.5f * (float) std::sin(juce::MathConstants<double>::twoPi * 440.0 * i / sampleRate));
+
+    auto data = SampleData::fromBuffer("sine", sine, sampleRate);
+    juce::BigInteger allNotes;
+    allNotes.setRange(0, 128, true);
+
+    juce::SynthesiserSound::Ptr sound = new SampleSound(data, PeakPyramid::build(data->getView()), allNotes, 69);
+
+    // as it comes, the stock one doesn't split blocks into spans shorter than 32 frames
+    auto stock = createSynth(sound, sampleRate, blockSize);
+
+    auto scheduled = createSynth(sound, sampleRate, blockSize);
+    scheduled->setControlInterval(controlInterval);
+
+    juce::AudioBuffer<float> output(2, blockSize);
+
+    auto render = [&](YellowRoseSynth& synth, bool useScheduler) {
+        synth.allNotesOff(0, false);
+
+        auto spansBefore = synth.getNumRenderSpans();
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (auto& midi : blocks) {
+            output.clear();
+
+            if (useScheduler)
+                synth.renderBlock(output, midi, 0, blockSize);
+            else
+                synth.renderNextBlock(output, midi, 0, blockSize);
+        }
+
+        auto ms = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0;
+        return std::make_pair(ms, synth.getNumRenderSpans() - spansBefore);
+    };
+
+    result.stockMs = result.scheduledMs = std::numeric_limits<double>::max();
+
+    for (int run = 0; run < numRuns; ++run) {
+        auto [stockMs, stockSpans] = render(*stock, false);
+        auto [scheduledMs, scheduledSpans] = render(*scheduled, true);
+
+        result.stockMs = juce::jmin(result.stockMs, stockMs);
+        result.scheduledMs = juce::jmin(result.scheduledMs, scheduledMs);
+        result.stockSpans = stockSpans;
+        result.scheduledSpans = scheduledSpans;
+    }
+
+    return result;
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    MidiBenchmark.h
+    Created: 28 Dec 2024 3:51:20pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Replays a MIDI file through two identical synthesisers, one driven by the
+    stock juce::Synthesiser::renderNextBlock at its default settings and one by
+    YellowRoseSynth::renderBlock, and times both. Each plays a sine sample
+    mapped over the whole keyboard.
+
+    Takes as long as rendering the file a few times over, don't call it on the
+    audio thread.
+*/
+struct MidiBenchmark
+{
+    struct Result
+    {
+        double lengthSeconds{ 0.0 };
+        int numEvents{ 0 };
+
+        /** Best of the runs, to render the whole file. */
+        double stockMs{ 0.0 }, scheduledMs{ 0.0 };
+
+        /** Spans the voices were rendered in over one run. */
+        juce::int64 stockSpans{ 0 }, scheduledSpans{ 0 };
+
+        juce::String toString() const;
+    };
+
+    /** The kind of file that fragments blocks: 16th note chords of six notes, with
+        pitch-bend, mod wheel and expression on every tick at 960 PPQ and 120 bpm.
+    */
+    static juce::MidiFile createStressFile(double lengthSeconds);
+
+    static Result run(const juce::MidiFile& file, double sampleRate, int blockSize, int controlInterval, int numRuns = 3);
+};
@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+    Created: 8 Feb 2025 4:05:37pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include "PluginProcessor.h"
+
+namespace
+{
+    juce::Result readSequence(const juce::File& file, juce::MidiMessageSequence& sequence)
+    {
+        juce::FileInputStream stream(file);
+        juce::MidiFile midi;
+
+        if (!stream.openedOk() || !midi.readFrom(stream))
+            return juce::Result::fail("Can't read " + file.getFullPathName());
+
+        midi.convertTimestampTicksToSeconds();
+
+        for (int i = 0; i < midi.getNumTracks(); ++i)
+            sequence.addSequence(*midi.getTrack(i), 0.0);
+
+        sequence.sort();
+        return juce::Result::ok();
+    }
+
+    juce::Result applyState(YellowRoseAudioProcessor& processor, const juce::File& file)
+    {
+        juce::MemoryBlock state;
+
+        if (!file.loadFileAsData(state))
+            return juce::Result::fail("Can't read " + file.getFullPathName());
+
+        processor.setStateInformation(state.getData(), (int) state.getSize());
+        return juce::Result::ok();
+    }
+
+    juce::Result applyParameters(YellowRoseAudioProcessor& processor, const juce::StringPairArray& parameters)
+    {
+        for (auto& id : parameters.getAllKeys()) {
+            auto* parameter = processor.getAPVTS().getParameter(id);
+
+            if (parameter == nullptr)
+                return juce::Result::fail("There's no parameter called " + id);
+
+            auto value = parameters[id].getFloatValue();
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        }
+
+        return juce::Result::ok();
+    }
+
+    bool waitForSound(YellowRoseAudioProcessor& processor, int timeoutMs)
+    {
+        auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) timeoutMs;
+
+        // a state and a sample both given load one after the other, the sample is the one played
+        while (!processor.isSampleLoaded()) {
+            if (juce::Time::getMillisecondCounter() > deadline)
+                return false;
+
+            juce::Thread::sleep(5);
+        }
+
+        return true;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& file, const OfflineRenderer::Settings& settings)
+    {
+        if (!file.getParentDirectory().createDirectory() || (file.exists() && !file.deleteFile()))
+            return nullptr;
+
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+
+        if (!stream->openedOk())
+            return nullptr;
+
+        std::unique_ptr<juce::AudioFormatWriter> writer(juce::WavAudioFormat().createWriterFor(stream.get(), settings.sampleRate, 2,
+                                                                                               settings.bitDepth, {}, 0));
+
+        // the writer owns the stream from here on
+        if (writer != nullptr)
+            stream.release();
+
+        return writer;
+    }
+}
+
+//==============================================================================
+OfflineRenderer::Outcome OfflineRenderer::render(const Job& job, const Settings& settings)
+{
+    Outcome outcome;
+    auto fail = [&outcome](const juce::String& message) {
+        outcome.result = juce::Result::fail(message);
+        return outcome;
+    };
+
+    juce::MidiMessageSequence sequence;
+    auto read = readSequence(job.midi, sequence);
+
+    if (read.failed())
+        return fail(read.getErrorMessage());
+
+    if (job.sample == juce::File() && job.state == juce::File())
+        return fail("Nothing to play, give a sample or a state");
+
+    if (job.sample != juce::File() && !job.sample.existsAsFile())
+        return fail("Can't find " + job.sample.getFullPathName());
+
+    YellowRoseAudioProcessor processor;
+
+    // before the load, so long samples are decoded instead of streamed
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(settings.sampleRate, settings.blockSize);
+    processor.prepareToPlay(settings.sampleRate, settings.blockSize);
+
+    if (job.state != juce::File()) {
+        auto applied = applyState(processor, job.state);
+
+        if (applied.failed())
+            return fail(applied.getErrorMessage());
+    }
+
+    auto applied = applyParameters(processor, settings.parameters);
+
+    if (applied.failed())
+        return fail(applied.getErrorMessage());
+
+    if (job.sample != juce::File())
+        processor.loadFile(job.sample.getFullPathName());
+
+    if (!waitForSound(processor, settings.loadTimeoutMs))
+        return fail("The sample didn't load");
+
+    auto writer = createWriter(job.output, settings);
+
+    if (writer == nullptr)
+        return fail("Can't write " + job.output.getFullPathName());
+
+    auto start = juce::Time::getHighResolutionTicks();
+    auto numFrames = (juce::int64) std::ceil((sequence.getEndTime() + settings.tailSeconds) * settings.sampleRate);
+
+    juce::AudioBuffer<float> buffer(2, settings.blockSize);
+    juce::MidiBuffer midi;
+    int nextEvent = 0;
+
+    for (juce::int64 position = 0; position < numFrames; position += settings.blockSize) {
+        auto numSamples = (int) juce::jmin((juce::int64) settings.blockSize, numFrames - position);
+
+        midi.clear();
+
+        while (nextEvent < sequence.getNumEvents()) {
+            const auto& message = sequence.getEventPointer(nextEvent)->message;
+            auto frame = juce::roundToInt(message.getTimeStamp() * settings.sampleRate);
+
+            if (frame >= position + numSamples)
+                break;
+
+            midi.addEvent(message, (int) juce::jmax((juce::int64) 0, frame - position));
+            ++nextEvent;
+        }
+
+        // the last block is shorter, it refers to the same channels
+        juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), 2, numSamples);
+        block.clear();
+        processor.processBlock(block, midi);
+
+        if (!writer->writeFromAudioSampleBuffer(block, 0, numSamples))
+            return fail("Can't write " + job.output.getFullPathName());
+    }
+
+    writer.reset();
+    processor.releaseResources();
+
+    outcome.audioSeconds = (double) numFrames / settings.sampleRate;
+    outcome.renderSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    return outcome;
+}
+
+std::vector<OfflineRenderer::Outcome> OfflineRenderer::renderAll(const std::vector<Job>& jobs, const Settings& settings, int numThreads)
+{
+    std::vector<Outcome> outcomes(jobs.size());
+    juce::ThreadPool pool(juce::jlimit(1, juce::jmax(1, (int) jobs.size()), numThreads));
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+        pool.addJob([&jobs, &settings, &outcomes, i] { outcomes[i] = render(jobs[i], settings); });
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep(20);
+
+    return outcomes;
+}
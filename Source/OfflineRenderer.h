@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+    Created: 8 Feb 2025 4:05:37pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Bounces a MIDI file through a YellowRoseAudioProcessor of its own into a WAV
+    file, as fast as the processor renders. Nothing is played or waited for apart
+    from the sample load.
+
+    Each render is independent, so renderAll() just runs them on a thread pool.
+    Renders of the same sample share it through the SampleStore, it's only
+    decoded once however many stems use it.
+*/
+struct OfflineRenderer
+{
+    struct Settings
+    {
+        double sampleRate{ 48000.0 };
+        int blockSize{ 512 };
+
+        /** Rendered after the last MIDI event, for releases to ring out. */
+        double tailSeconds{ 2.0 };
+
+        /** 16, 24 or 32 for floating point. */
+        int bitDepth{ 24 };
+
+        /** Parameter IDs and values in the parameter's own units, applied after the state. */
+        juce::StringPairArray parameters;
+
+        /** How long to wait for the sample before giving up. */
+        int loadTimeoutMs{ 120000 };
+    };
+
+    struct Job
+    {
+        /** A sample or an SFZ file. Optional when the state refers to one. */
+        juce::File sample;
+
+        /** A state saved by the plugin, optional. */
+        juce::File state;
+
+        juce::File midi;
+        juce::File output;
+    };
+
+    struct Outcome
+    {
+        juce::Result result{ juce::Result::ok() };
+        double audioSeconds{ 0.0 };
+        double renderSeconds{ 0.0 };
+
+        /** How many times faster than real time the render ran. */
+        double getSpeed() const { return renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0; }
+    };
+
+    static Outcome render(const Job& job, const Settings& settings);
+
+    /** Renders the jobs on numThreads threads and returns their outcomes in job order. */
+    static std::vector<Outcome> renderAll(const std::vector<Job>& jobs, const Settings& settings, int numThreads);
+};
@@ -0,0 +1,289 @@
+/*
+  ==============================================================================
+
+    PeakPyramid.cpp
+    Created: 23 Nov 2024 1:14:36pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "PeakPyramid.h"
+
+namespace
+{
+    constexpr int peakFileMagic = 0x4b505259; // "YRPK"
+    constexpr int peakFileVersion = 1;
+    constexpr int readChunkSize = 1 << 16;
+
+    Peak combine(const Peak& a, const Peak& b) noexcept
+    {
+        return { juce::jmin(a.min, b.min),
+                 juce::jmax(a.max, b.max),
+                 std::sqrt((a.rms * a.rms + b.rms * b.rms) * 0.5f) };
+    }
+}
+
+//==============================================================================
+PeakPyramid::Builder::Builder(int numChannels) : mNumChannels(juce::jlimit(1, 2, numChannels))
+{
+}
+
+void PeakPyramid::Builder::addFrames(const float* const* channels, int numFrames)
+{
+    int done = 0;
+
+    while (done < numFrames) {
+        auto numInBin = juce::jmin(numFrames - done, baseBinSize - mFramesInBin);
+
+        for (int ch = 0; ch < mNumChannels; ++ch) {
+            auto range = juce::FloatVectorOperations::findMinAndMax(channels[ch] + done, numInBin);
+            auto& current = mCurrent[ch];
+
+            if (mFramesInBin == 0) {
+                current.min = range.getStart();
+                current.max = range.getEnd();
+            }
+            else {
+                current.min = juce::jmin(current.min, range.getStart());
+                current.max = juce::jmax(current.max, range.getEnd());
+            }
+
+            for (int i = 0; i < numInBin; ++i)
+                mSumOfSquares[ch] += (double) channels[ch][done + i] * channels[ch][done + i];
+        }
+
+        mFramesInBin += numInBin;
+        done += numInBin;
+
+        if (mFramesInBin == baseBinSize)
+            finishBin();
+    }
+
+    mNumFrames += numFrames;
+}
+
+void PeakPyramid::Builder::finishBin()
+{
+    for (int ch = 0; ch < mNumChannels; ++ch) {
+        mCurrent[ch].rms = (float) std::sqrt(mSumOfSquares[ch] / mFramesInBin);
+        mBase.push_back(mCurrent[ch]);
+        mSumOfSquares[ch] = 0.0;
+    }
+
+    mFramesInBin = 0;
+}
+
+PeakPyramid::Ptr PeakPyramid::Builder::finish()
+{
+    if (mFramesInBin > 0)
+        finishBin();
+
+    return new PeakPyramid(mNumChannels, mNumFrames, std::move(mBase));
+}
+
+PeakPyramid::Ptr PeakPyramid::Builder::snapshot(juce::int64 totalNumFrames) const
+{
+    totalNumFrames = juce::jmax(totalNumFrames, mNumFrames);
+
+    auto numBins = (size_t) ((totalNumFrames + baseBinSize - 1) / baseBinSize);
+    std::vector<Peak> base;
+    base.reserve(numBins * (size_t) mNumChannels);
+    base.insert(base.end(), mBase.begin(), mBase.end());
+
+    // the bin that's being filled, as far as it goes
+    if (mFramesInBin > 0) {
+        for (int ch = 0; ch < mNumChannels; ++ch) {
+            auto peak = mCurrent[ch];
+            peak.rms = (float) std::sqrt(mSumOfSquares[ch] / mFramesInBin);
+            base.push_back(peak);
+        }
+    }
+
+    base.resize(numBins * (size_t) mNumChannels);
+    return new PeakPyramid(mNumChannels, totalNumFrames, std::move(base));
+}
+
+//==============================================================================
+PeakPyramid::PeakPyramid(int numChannels, juce::int64 numFrames, std::vector<Peak>&& base)
+    : mNumChannels(numChannels), mNumFrames(numFrames)
+{
+    mLevels.push_back(std::move(base));
+    buildUpperLevels();
+}
+
+PeakPyramid::PeakPyramid(int numChannels, juce::int64 numFrames, std::vector<std::vector<Peak>>&& levels)
+    : mNumChannels(numChannels), mNumFrames(numFrames), mLevels(std::move(levels))
+{
+}
+
+void PeakPyramid::buildUpperLevels()
+{
+    while (mLevels.back().size() > (size_t) mNumChannels) {
+        const auto& below = mLevels.back();
+        auto numBinsBelow = below.size() / (size_t) mNumChannels;
+        auto numBins = (numBinsBelow + 1) / 2;
+
+        std::vector<Peak> level;
+        level.reserve(numBins * (size_t) mNumChannels);
+
+        for (size_t bin = 0; bin < numBins; ++bin) {
+            for (int ch = 0; ch < mNumChannels; ++ch) {
+                const auto& a = below[(bin * 2) * (size_t) mNumChannels + (size_t) ch];
+
+                if (bin * 2 + 1 < numBinsBelow)
+                    level.push_back(combine(a, below[(bin * 2 + 1) * (size_t) mNumChannels + (size_t) ch]));
+                else
+                    level.push_back(a);
+            }
+        }
+
+        mLevels.push_back(std::move(level));
+    }
+}
+
+PeakPyramid::Ptr PeakPyramid::build(const SampleView& view)
+{
+    Builder builder(view.numChannels);
+    builder.addFrames(view.channels, view.numFrames);
+    return builder.finish();
+}
+
+PeakPyramid::Ptr PeakPyramid::build(juce::AudioFormatReader& reader, const std::function<bool()>& shouldAbort)
+{
+    auto numChannels = juce::jlimit(1, 2, (int) reader.numChannels);
+    juce::AudioBuffer<float> chunk(numChannels, readChunkSize);
+    Builder builder(numChannels);
+
+    for (juce::int64 pos = 0; pos < reader.lengthInSamples; pos += readChunkSize) {
+        if (shouldAbort != nullptr && shouldAbort())
+            return nullptr;
+
+        auto numToRead = (int) juce::jmin((juce::int64) readChunkSize, reader.lengthInSamples - pos);
+        reader.read(chunk.getArrayOfWritePointers(), numChannels, pos, numToRead);
+        builder.addFrames(chunk.getArrayOfReadPointers(), numToRead);
+    }
+
+    return builder.finish();
+}
+
+//==============================================================================
+juce::File PeakPyramid::getPeakFileFor(const juce::File& sourceFile)
+{
+    // next to the SampleCache rather than the sample, libraries are often read-only or shared.
+    // Named by the full path, the file name alone isn't unique across libraries.
+    auto pathHash = juce::String::toHexString(sourceFile.getFullPathName().hashCode64()).paddedLeft('0', 16);
+
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("YellowRose").getChildFile("Peaks")
+               .getChildFile(sourceFile.getFileName() + "-" + pathHash + ".yrpeaks");
+}
+
+PeakPyramid::Ptr PeakPyramid::loadFrom(const juce::File& peakFile, const juce::File& sourceFile, juce::int64 expectedNumFrames)
+{
+    if (!peakFile.existsAsFile() || peakFile.getLastModificationTime() < sourceFile.getLastModificationTime())
+        return nullptr;
+
+    juce::FileInputStream in(peakFile);
+
+    if (in.failedToOpen()
+        || in.readInt() != peakFileMagic
+        || in.readInt() != peakFileVersion
+        || in.readInt64() != expectedNumFrames)
+        return nullptr;
+
+    auto numChannels = in.readInt();
+    auto binSize = in.readInt();
+    auto numLevels = in.readInt();
+
+    if (numChannels < 1 || numChannels > 2 || binSize != baseBinSize || numLevels < 1 || numLevels > 64)
+        return nullptr;
+
+    std::vector<std::vector<Peak>> levels;
+    auto expectedBins = (expectedNumFrames + baseBinSize - 1) / baseBinSize;
+
+    for (int i = 0; i < numLevels; ++i) {
+        auto numBins = in.readInt64();
+
+        if (numBins != expectedBins)
+            return nullptr;
+
+        std::vector<Peak> level((size_t) numBins * (size_t) numChannels);
+        auto numBytes = (int) (level.size() * sizeof(Peak));
+
+        if (in.read(level.data(), numBytes) != numBytes)
+            return nullptr;
+
+        levels.push_back(std::move(level));
+        expectedBins = (expectedBins + 1) / 2;
+    }
+
+    return new PeakPyramid(numChannels, expectedNumFrames, std::move(levels));
+}
+
+bool PeakPyramid::saveTo(const juce::File& peakFile) const
+{
+    if (!peakFile.getParentDirectory().createDirectory())
+        return false;
+
+    juce::TemporaryFile temp(peakFile);
+
+    {
+        juce::FileOutputStream out(temp.getFile());
+
+        if (!out.openedOk())
+            return false;
+
+        out.writeInt(peakFileMagic);
+        out.writeInt(peakFileVersion);
+        out.writeInt64(mNumFrames);
+        out.writeInt(mNumChannels);
+        out.writeInt(baseBinSize);
+        out.writeInt((int) mLevels.size());
+
+        for (const auto& level : mLevels) {
+            out.writeInt64((juce::int64) (level.size() / (size_t) mNumChannels));
+            out.write(level.data(), level.size() * sizeof(Peak));
+        }
+
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+//==============================================================================
+Peak PeakPyramid::getPeak(int channel, double startFrame, double endFrame) const noexcept
+{
+    startFrame = juce::jmax(0.0, startFrame);
+    endFrame = juce::jmin((double) mNumFrames, endFrame);
+
+    if (endFrame <= startFrame || mNumFrames == 0)
+        return {};
+
+    auto ch = (size_t) juce::jlimit(0, mNumChannels - 1, channel);
+    auto span = endFrame - startFrame;
+
+    // the coarsest level whose bins still fit in the range, so at most three bins overlap it
+    int level = 0;
+
+    while (level + 1 < getNumLevels() && (double) ((juce::int64) baseBinSize << (level + 1)) <= span)
+        ++level;
+
+    const auto& bins = mLevels[(size_t) level];
+    auto binSize = (juce::int64) baseBinSize << level;
+    auto lastBinInLevel = (juce::int64) (bins.size() / (size_t) mNumChannels) - 1;
+
+    auto firstBin = juce::jmin(lastBinInLevel, (juce::int64) startFrame / binSize);
+    auto lastBin = juce::jmin(lastBinInLevel, ((juce::int64) std::ceil(endFrame) - 1) / binSize);
+
+    auto result = bins[(size_t) firstBin * (size_t) mNumChannels + ch];
+
+    for (auto bin = firstBin + 1; bin <= lastBin; ++bin)
+        result = combine(result, bins[(size_t) bin * (size_t) mNumChannels + ch]);
+
+    return result;
+}
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    PeakPyramid.h
+    Created: 23 Nov 2024 1:14:36pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleData.h"
+
+//==============================================================================
+struct Peak
+{
+    float min{ 0.0f }, max{ 0.0f }, rms{ 0.0f };
+};
+
+//==============================================================================
+/*
+    Min/max/RMS summaries of a sample at power-of-two resolutions, built once when
+    the sample is loaded. Level 0 summarises baseBinSize frames per bin and every
+    level above halves the resolution, so any range of the sample can be summarised
+    by looking at no more than three bins.
+
+    Pyramids can be written to the application data directory and read back on
+    the next load, which saves a full pass over files that aren't decoded into
+    memory. Sample folders are left alone, they may well be read-only.
+*/
+class PeakPyramid  : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<PeakPyramid>;
+
+    static constexpr int baseBinSize = 256;
+
+    //==============================================================================
+    /** Accumulates frames in order and turns them into a pyramid. */
+    class Builder
+    {
+    public:
+        Builder(int numChannels);
+
+        void addFrames(const float* const* channels, int numFrames);
+        Ptr finish();
+
+        /** A pyramid of the frames added so far, as the start of a sample that's
+            totalNumFrames long with silence after them. Leaves the builder as it is,
+            for showing a sample that's still being decoded.
+        */
+        Ptr snapshot(juce::int64 totalNumFrames) const;
+
+        juce::int64 getNumFrames() const noexcept { return mNumFrames; }
+
+    private:
+        int mNumChannels;
+        juce::int64 mNumFrames{ 0 };
+        std::vector<Peak> mBase;
+
+        Peak mCurrent[2];
+        double mSumOfSquares[2]{};
+        int mFramesInBin{ 0 };
+
+        void finishBin();
+    };
+
+    //==============================================================================
+    static Ptr build(const SampleView& view);
+
+    /** Reads the whole file in chunks. Returns null if shouldAbort returns true on the way. */
+    static Ptr build(juce::AudioFormatReader& reader, const std::function<bool()>& shouldAbort);
+
+    /** Where the pyramid for a sample is kept on disk. */
+    static juce::File getPeakFileFor(const juce::File& sourceFile);
+
+    /** Returns null unless the file exists, is newer than the sample and matches its length. */
+    static Ptr loadFrom(const juce::File& peakFile, const juce::File& sourceFile, juce::int64 expectedNumFrames);
+    bool saveTo(const juce::File& peakFile) const;
+
+    //==============================================================================
+    juce::int64 getNumFrames() const noexcept { return mNumFrames; }
+    int getNumChannels() const noexcept { return mNumChannels; }
+    int getNumLevels() const noexcept { return (int) mLevels.size(); }
+
+    /** Summarises the frames in [startFrame, endFrame) of a channel, in constant time.
+        Ranges shorter than a level 0 bin return the whole bin they fall in.
+    */
+    Peak getPeak(int channel, double startFrame, double endFrame) const noexcept;
+
+private:
+    PeakPyramid(int numChannels, juce::int64 numFrames, std::vector<Peak>&& base);
+    PeakPyramid(int numChannels, juce::int64 numFrames, std::vector<std::vector<Peak>>&& levels);
+
+    void buildUpperLevels();
+
+    int mNumChannels;
+    juce::int64 mNumFrames;
+
+    // bins are interleaved by channel: [bin * numChannels + channel]
+    std::vector<std::vector<Peak>> mLevels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PeakPyramid)
+};
@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    PitchCache.cpp
+    Created: 1 Feb 2025 10:48:21am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "PitchCache.h"
+
+namespace
+{
+    constexpr int maxProbes = 8;
+}
+
+PitchCache::PitchCache() : juce::Thread("YellowRose pitch cache")
+{
+    startThread(juce::Thread::Priority::low);
+}
+
+PitchCache::~PitchCache()
+{
+    stopThread(4000);
+
+    // requests that were never rendered still hold a reference to their source
+    for (;;) {
+        auto scope = mRequestFifo.read(1);
+
+        if (scope.blockSize1 == 0)
+            break;
+
+        SampleData::Ptr source(mRequests[(size_t) scope.startIndex1].source);
+        source->decReferenceCountWithoutDeleting();
+    }
+}
+
+int PitchCache::getHomeSlot(const SampleData* source, double ratio, InterpolationMode mode) noexcept
+{
+    juce::uint64 ratioBits;
+    std::memcpy(&ratioBits, &ratio, sizeof(ratioBits));
+
+    auto hash = (juce::uint64) reinterpret_cast<juce::pointer_sized_uint>(source);
+    hash ^= ratioBits * 0x9e3779b97f4a7c15ull;
+    hash ^= ((juce::uint64) mode + 1) * 0xc2b2ae3d27d4eb4full;
+    hash ^= hash >> 29;
+
+    return (int) (hash & (numSlots - 1));
+}
+
+PitchCache::Entry* PitchCache::find(SampleData* source, double ratio, InterpolationMode mode) noexcept
+{
+    if (!isEnabled() || source == nullptr)
+        return nullptr;
+
+    // an evicted copy is only freed once no find() can be between reading its slot and adding a reference
+    mFindsInFlight.fetch_add(1);
+    const juce::ScopeGuard findDone{ [this] { mFindsInFlight.fetch_sub(1); } };
+
+    auto home = getHomeSlot(source, ratio, mode);
+
+    for (int i = 0; i < maxProbes; ++i) {
+        auto* entry = mSlots[(size_t) ((home + i) & (numSlots - 1))].load();
+
+        if (entry != nullptr && entry->matches(source, ratio, mode)) {
+            entry->incReferenceCount();
+            entry->mLastUsed.store(mUseCounter.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return entry;
+        }
+    }
+
+    // a full queue just means this note asks again next time
+    auto scope = mRequestFifo.write(1);
+
+    if (scope.blockSize1 > 0) {
+        source->incReferenceCount();
+        mRequests[(size_t) scope.startIndex1] = { source, ratio, mode };
+    }
+
+    return nullptr;
+}
+
+void PitchCache::clear()
+{
+    const NonRealtimeLock::ScopedLockType sl(mWriteLock);
+
+    for (int slot = 0; slot < numSlots; ++slot)
+        evict(slot);
+}
+
+//==============================================================================
+void PitchCache::run()
+{
+    while (!threadShouldExit()) {
+        releaseRetired();
+
+        Request request{};
+        bool hasRequest = false;
+
+        {
+            auto scope = mRequestFifo.read(1);
+
+            if (scope.blockSize1 > 0) {
+                request = mRequests[(size_t) scope.startIndex1];
+                hasRequest = true;
+            }
+        }
+
+        if (hasRequest)
+            render(request);
+        else
+            wait(10);
+    }
+}
+
+void PitchCache::render(const Request& request)
+{
+    // takes over the reference the audio thread added
+    SampleData::Ptr source(request.source);
+    request.source->decReferenceCountWithoutDeleting();
+
+    {
+        const NonRealtimeLock::ScopedLockType sl(mWriteLock);
+
+        // a note played several times before its copy was ready asks several times
+        for (auto* entry : mEntries) {
+            if (entry->matches(source.get(), request.ratio, request.mode))
+                return;
+        }
+    }
+
+    auto view = source->getView();
+
+    // the last frame read is still inside the sample, the interpolators only look a few frames further
+    auto numFrames = (juce::int64) std::floor((view.numFrames - 1) / request.ratio) + 1;
+    auto sizeInBytes = numFrames * view.numChannels * (juce::int64) sizeof(float);
+
+    if (numFrames <= 1 || numFrames > std::numeric_limits<int>::max() / 2 || sizeInBytes > mBudgetInBytes)
+        return;
+
+    auto rendered = SampleData::build(source->getName(), view.numChannels, (int) numFrames, view.sampleRate / request.ratio,
+                                      [&](float* const* channels) {
+        for (int ch = 0; ch < view.numChannels; ++ch)
+            Interpolator::process(request.mode, view.getChannel(ch), 0.0, request.ratio, channels[ch], (int) numFrames);
+    });
+
+    Entry::Ptr entry = new Entry(source, request.ratio, request.mode, rendered);
+    auto age = [this](int slot) {
+        auto* e = mSlots[(size_t) slot].load(std::memory_order_relaxed);
+        return e != nullptr ? mUseCounter.load(std::memory_order_relaxed) - e->mLastUsed.load(std::memory_order_relaxed) : 0u;
+    };
+
+    const NonRealtimeLock::ScopedLockType sl(mWriteLock);
+
+    // make room under the budget, oldest first
+    while (mSizeInBytes + (juce::int64) entry->getSizeInBytes() > mBudgetInBytes && !mEntries.isEmpty()) {
+        int oldest = -1;
+
+        for (int slot = 0; slot < numSlots; ++slot) {
+            if (mSlots[(size_t) slot].load(std::memory_order_relaxed) != nullptr && (oldest < 0 || age(slot) > age(oldest)))
+                oldest = slot;
+        }
+
+        if (oldest < 0)
+            break;
+
+        evict(oldest);
+    }
+
+    // the first free slot from home, or the oldest one in reach
+    auto home = getHomeSlot(source.get(), request.ratio, request.mode);
+    int target = -1, oldestInReach = home;
+
+    for (int i = 0; i < maxProbes && target < 0; ++i) {
+        auto slot = (home + i) & (numSlots - 1);
+
+        if (mSlots[(size_t) slot].load(std::memory_order_relaxed) == nullptr)
+            target = slot;
+        else if (age(slot) > age(oldestInReach))
+            oldestInReach = slot;
+    }
+
+    if (target < 0) {
+        evict(oldestInReach);
+        target = oldestInReach;
+    }
+
+    entry->mLastUsed = mUseCounter.load(std::memory_order_relaxed);
+    mEntries.add(entry);
+    mSizeInBytes += (juce::int64) entry->getSizeInBytes();
+    mSlots[(size_t) target].store(entry.get(), std::memory_order_release);
+}
+
+void PitchCache::evict(int slot)
+{
+    // called with mWriteLock held
+    if (auto* entry = mSlots[(size_t) slot].exchange(nullptr)) {
+        mSizeInBytes -= (juce::int64) entry->getSizeInBytes();
+        mRetired.add(entry);
+        mEntries.removeObject(entry);
+    }
+}
+
+void PitchCache::releaseRetired()
+{
+    juce::ReferenceCountedArray<Entry> unused;
+
+    {
+        const NonRealtimeLock::ScopedLockType sl(mWriteLock);
+
+        // every retired copy is out of its slot already. A find() that read the slot before
+        // that may not have added its reference yet, so this waits for a moment with none running.
+        // find() is short and only runs for note-ons, the next pass gets one.
+        if (mRetired.isEmpty() || mFindsInFlight.load() != 0)
+            return;
+
+        // like the ReleasePool: once only this array holds one, no voice can pick it up again
+        for (int i = mRetired.size(); --i >= 0;) {
+            if (mRetired.getObjectPointerUnchecked(i)->getReferenceCount() == 1)
+                unused.add(mRetired.removeAndReturn(i));
+        }
+    }
+
+    // the copies are freed here, outside the lock
+}
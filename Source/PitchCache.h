@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    PitchCache.h
+    Created: 1 Feb 2025 10:48:21am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleData.h"
+#include "Interpolator.h"
+#include "RealtimeGuard.h"
+
+//==============================================================================
+/*
+    Pre-rendered copies of a sample at the pitch ratios it actually gets played
+    at, for one-shots and drums where the same few notes come up over and over.
+
+    The first note at a ratio plays interpolated as usual and asks for a copy. A
+    background thread renders it and publishes it in a fixed table of slots, and
+    later notes at that ratio play the copy with a step of one, which is a plain
+    copy and mix. The audio thread only ever reads the table and queues requests
+    through a FIFO, it never waits and never frees anything.
+
+    Copies are evicted least recently used first once they go over the memory
+    budget. An evicted copy that a voice is still playing is kept until it's done,
+    and one that a lookup on the audio thread might still be about to take is
+    kept until no lookup is running.
+*/
+class PitchCache  : private juce::Thread
+{
+public:
+    static constexpr int numSlots = 256;
+    static constexpr juce::int64 defaultBudgetInBytes = (juce::int64) 256 << 20;
+
+    /** One rendered copy. Voices hold a reference while they play it. */
+    class Entry  : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Entry>;
+
+        Entry(SampleData::Ptr source, double ratio, InterpolationMode mode, SampleData::Ptr rendered)
+            : mSource(std::move(source)), mRatio(ratio), mMode(mode), mRendered(std::move(rendered)) {}
+
+        bool matches(const SampleData* source, double ratio, InterpolationMode mode) const noexcept
+        {
+            return mSource.get() == source && mRatio == ratio && mMode == mode;
+        }
+
+        SampleView getView() const noexcept { return mRendered->getView(); }
+        size_t getSizeInBytes() const noexcept { return mRendered->getSizeInBytes(); }
+
+    private:
+        friend class PitchCache;
+
+        // the source is kept alive so its address can't be reused by another sample
+        const SampleData::Ptr mSource;
+        const double mRatio;
+        const InterpolationMode mMode;
+        const SampleData::Ptr mRendered;
+        std::atomic<juce::uint32> mLastUsed{ 0 };
+    };
+
+    PitchCache();
+    ~PitchCache() override;
+
+    /** Audio thread. Returns the copy with a reference added for the caller, or
+        null and queues it to be rendered. Release it with
+        decReferenceCountWithoutDeleting() once the note is over.
+    */
+    Entry* find(SampleData* source, double ratio, InterpolationMode mode) noexcept;
+
+    void setEnabled(bool shouldBeEnabled) noexcept { mEnabled = shouldBeEnabled; }
+    bool isEnabled() const noexcept { return mEnabled.load(std::memory_order_relaxed); }
+
+    void setBudgetInBytes(juce::int64 budget) { mBudgetInBytes = budget; }
+    juce::int64 getSizeInBytes() const noexcept { return mSizeInBytes.load(std::memory_order_relaxed); }
+
+    /** Evicts every copy, for when the sound changes. Not on the audio thread. */
+    void clear();
+
+private:
+    struct Request
+    {
+        SampleData* source;
+        double ratio;
+        InterpolationMode mode;
+    };
+
+    void run() override;
+    void render(const Request& request);
+    void evict(int slot);
+    void releaseRetired();
+
+    static int getHomeSlot(const SampleData* source, double ratio, InterpolationMode mode) noexcept;
+
+    std::atomic<bool> mEnabled{ false };
+    std::atomic<juce::int64> mBudgetInBytes{ defaultBudgetInBytes };
+    std::atomic<juce::int64> mSizeInBytes{ 0 };
+    std::atomic<juce::uint32> mUseCounter{ 0 };
+
+    // read by the audio thread, only written under mWriteLock
+    std::array<std::atomic<Entry*>, numSlots> mSlots{};
+    juce::ReferenceCountedArray<Entry> mEntries, mRetired;
+    NonRealtimeLock mWriteLock;
+
+    // how many find() calls are looking at the slots, the retired copies wait until it's 0
+    std::atomic<int> mFindsInFlight{ 0 };
+
+    // from the audio thread to the render thread, each request holds a reference to its source
+    juce::AbstractFifo mRequestFifo{ 64 };
+    std::array<Request, 64> mRequests{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchCache)
+};
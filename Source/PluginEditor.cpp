@@ -11,13 +11,39 @@
 
 //==============================================================================
 YellowRoseAudioProcessorEditor::YellowRoseAudioProcessorEditor (YellowRoseAudioProcessor& p)
-    : AudioProcessorEditor (&p), mWaveThumbnail(p), mADSR(p), audioProcessor(p)
+    : AudioProcessorEditor (&p), mWaveThumbnail(p), mADSR(p), mLoop(p), mFilter(p), mTelemetry(p), audioProcessor(p)
 {
     //mWaveThumbnail.onClick = [&]() { audioProcessor.loadFile(); };
     addAndMakeVisible(mWaveThumbnail);
     addAndMakeVisible(mADSR);
+    addAndMakeVisible(mLoop);
+    addAndMakeVisible(mFilter);
+    addAndMakeVisible(mTelemetry);
 
-    setSize(600, 400);
+    mQualityBox.addItemList(Interpolator::getModeNames(), 1);
+    mQualityBox.setTooltip("Interpolation quality");
+    addAndMakeVisible(mQualityBox);
+    mQualityAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getAPVTS(), "QUALITY", mQualityBox);
+
+    mPolyphonySlider.setSliderStyle(juce::Slider::SliderStyle::IncDecButtons);
+    mPolyphonySlider.setTextBoxStyle(juce::Slider::TextBoxLeft, false, 40, 20);
+    mPolyphonySlider.setTooltip("Polyphony");
+    addAndMakeVisible(mPolyphonySlider);
+    mPolyphonyAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getAPVTS(), "POLYPHONY", mPolyphonySlider);
+
+    mStealingBox.addItemList(YellowRoseSynth::getStealingPolicyNames(), 1);
+    mStealingBox.setTooltip("Voice stealing");
+    addAndMakeVisible(mStealingBox);
+    mStealingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getAPVTS(), "STEALING", mStealingBox);
+
+    addAndMakeVisible(mMulticoreButton);
+    mMulticoreAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.getAPVTS(), "MULTICORE", mMulticoreButton);
+
+    mPitchCacheButton.setTooltip("Pre-render the notes that get played, for one-shots and drums");
+    addAndMakeVisible(mPitchCacheButton);
+    mPitchCacheAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.getAPVTS(), "PITCHCACHE", mPitchCacheButton);
+
+    setSize(600, 500);
 }
 
 YellowRoseAudioProcessorEditor::~YellowRoseAudioProcessorEditor()
@@ -32,6 +58,14 @@ void YellowRoseAudioProcessorEditor::paint (juce::Graphics& g)
 
 void YellowRoseAudioProcessorEditor::resized()
 {
-    mWaveThumbnail.setBoundsRelative(0.0f, 0.15f, 1.0f, 0.5f);
-    mADSR.setBoundsRelative(0.0f, 0.75f, 1.0f, 0.25f);
+    mWaveThumbnail.setBoundsRelative(0.0f, 0.12f, 1.0f, 0.4f);
+    mTelemetry.setBoundsRelative(0.0f, 0.53f, 1.0f, 0.06f);
+    mFilter.setBoundsRelative(0.0f, 0.6f, 1.0f, 0.2f);
+    mLoop.setBoundsRelative(0.0f, 0.8f, 0.6f, 0.2f);
+    mADSR.setBoundsRelative(0.6f, 0.8f, 0.4f, 0.2f);
+    mQualityBox.setBoundsRelative(0.02f, 0.025f, 0.2f, 0.065f);
+    mPolyphonySlider.setBoundsRelative(0.24f, 0.025f, 0.18f, 0.065f);
+    mStealingBox.setBoundsRelative(0.44f, 0.025f, 0.2f, 0.065f);
+    mMulticoreButton.setBoundsRelative(0.66f, 0.025f, 0.16f, 0.065f);
+    mPitchCacheButton.setBoundsRelative(0.82f, 0.025f, 0.16f, 0.065f);
 }
\ No newline at end of file
@@ -12,6 +12,9 @@
 #include "PluginProcessor.h"
 #include "WaveThumbnail.h"
 #include "ADSRComponent.h"
+#include "LoopComponent.h"
+#include "FilterComponent.h"
+#include "TelemetryComponent.h"
 
 //==============================================================================
 /**
@@ -29,6 +32,24 @@ public:
 private:
     WaveThumbnail mWaveThumbnail;
     ADSRComponent mADSR;
+    LoopComponent mLoop;
+    FilterComponent mFilter;
+    TelemetryComponent mTelemetry;
+
+    juce::ComboBox mQualityBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> mQualityAttachment;
+
+    juce::Slider mPolyphonySlider;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mPolyphonyAttachment;
+
+    juce::ComboBox mStealingBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> mStealingAttachment;
+
+    juce::ToggleButton mMulticoreButton{ "Multicore" };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> mMulticoreAttachment;
+
+    juce::ToggleButton mPitchCacheButton{ "One-shot" };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> mPitchCacheAttachment;
 
     YellowRoseAudioProcessor& audioProcessor;
 
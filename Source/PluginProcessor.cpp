@@ -8,30 +8,93 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "StreamingVoice.h"
+#include "SampleVoice.h"
 
 //==============================================================================
 YellowRoseAudioProcessor::YellowRoseAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       ), mAPVTS(*this, nullptr, "PARAMETERS", createParameters())
+     : AudioProcessor (createBusesProperties()), mAPVTS(*this, nullptr, "PARAMETERS", createParameters())
 #endif
 {
-    mFormatManager.registerBasicFormats();
-    mAPVTS.state.addListener(this);
-
-    for (int i = 0; i < mNumVoices; i++) {
-        mSampler.addVoice(new juce::SamplerVoice());
+    mAttack = mAPVTS.getRawParameterValue("ATTACK");
+    mDecay = mAPVTS.getRawParameterValue("DECAY");
+    mSustain = mAPVTS.getRawParameterValue("SUSTAIN");
+    mRelease = mAPVTS.getRawParameterValue("RELEASE");
+    mQuality = mAPVTS.getRawParameterValue("QUALITY");
+    mPolyphony = mAPVTS.getRawParameterValue("POLYPHONY");
+    mStealing = mAPVTS.getRawParameterValue("STEALING");
+    mMulticore = mAPVTS.getRawParameterValue("MULTICORE");
+    mPitchCacheEnabled = mAPVTS.getRawParameterValue("PITCHCACHE");
+    mLoopMode = mAPVTS.getRawParameterValue("LOOPMODE");
+    mLoopStart = mAPVTS.getRawParameterValue("LOOPSTART");
+    mLoopEnd = mAPVTS.getRawParameterValue("LOOPEND");
+    mLoopCrossfade = mAPVTS.getRawParameterValue("LOOPXFADE");
+    mFilterType = mAPVTS.getRawParameterValue("FILTERTYPE");
+    mCutoff = mAPVTS.getRawParameterValue("CUTOFF");
+    mResonance = mAPVTS.getRawParameterValue("RESONANCE");
+    mFilterEnvelopeAmount = mAPVTS.getRawParameterValue("FILTERENV");
+    mKeyTracking = mAPVTS.getRawParameterValue("KEYTRACK");
+    mFilterAttack = mAPVTS.getRawParameterValue("FATTACK");
+    mFilterDecay = mAPVTS.getRawParameterValue("FDECAY");
+    mFilterSustain = mAPVTS.getRawParameterValue("FSUSTAIN");
+    mFilterRelease = mAPVTS.getRawParameterValue("FRELEASE");
+
+    for (auto* id : { "ATTACK", "DECAY", "SUSTAIN", "RELEASE" })
+        mAPVTS.addParameterListener(id, &mEnvelopeFlag);
+
+    for (auto* id : { "QUALITY", "POLYPHONY", "STEALING", "MULTICORE", "PITCHCACHE" })
+        mAPVTS.addParameterListener(id, &mVoiceSettingsFlag);
+
+    for (auto* id : { "FILTERTYPE", "CUTOFF", "RESONANCE", "FILTERENV", "KEYTRACK", "FATTACK", "FDECAY", "FSUSTAIN", "FRELEASE" })
+        mAPVTS.addParameterListener(id, &mFilterFlag);
+
+    for (auto* id : { "LOOPMODE", "LOOPSTART", "LOOPEND", "LOOPXFADE" })
+        mAPVTS.addParameterListener(id, &mLoopListener);
+
+    mAPVTS.addParameterListener("MULTICORE", &mMulticoreListener);
+
+    updateLoopSettings();
+
+    // the whole pool is allocated here, the polyphony parameter only limits how much of it plays
+    for (int i = 0; i < maxPolyphony; i++) {
+        mSampleVoices.add(new SampleVoice());
+        mSampleVoices.getLast()->setPitchCache(&mPitchCache);
+        mVoices.add(mSampleVoices.getLast());
     }
+
+    for (int i = 0; i < numStreamingVoices; i++)
+        mVoices.add(new StreamingVoice(mDiskStreamer));
+
+    for (auto* voice : mVoices)
+        mSampler.addVoice(voice);
+
+    mSampleLoader.onSoundLoaded = [this](juce::SynthesiserSound::Ptr sound, const SampleLoader::SampleReference& reference) {
+        soundLoaded(sound, reference);
+    };
 }
 
 YellowRoseAudioProcessor::~YellowRoseAudioProcessor()
 {
+    for (auto* id : { "ATTACK", "DECAY", "SUSTAIN", "RELEASE" })
+        mAPVTS.removeParameterListener(id, &mEnvelopeFlag);
+
+    for (auto* id : { "QUALITY", "POLYPHONY", "STEALING", "MULTICORE", "PITCHCACHE" })
+        mAPVTS.removeParameterListener(id, &mVoiceSettingsFlag);
+
+    for (auto* id : { "FILTERTYPE", "CUTOFF", "RESONANCE", "FILTERENV", "KEYTRACK", "FATTACK", "FDECAY", "FSUSTAIN", "FRELEASE" })
+        mAPVTS.removeParameterListener(id, &mFilterFlag);
+
+    for (auto* id : { "LOOPMODE", "LOOPSTART", "LOOPEND", "LOOPXFADE" })
+        mAPVTS.removeParameterListener(id, &mLoopListener);
+
+    mAPVTS.removeParameterListener("MULTICORE", &mMulticoreListener);
+    mMulticoreListener.cancelPendingUpdate();
+
+    mSampleLoader.shutdown();
+
+    if (auto* sound = mPendingSound.exchange(nullptr))
+        sound->decReferenceCount();
 }
 
 //==============================================================================
@@ -102,14 +165,30 @@ void YellowRoseAudioProcessor::prepareToPlay (double sampleRate, int samplesPerB
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
-    mSampler.setCurrentPlaybackSampleRate(sampleRate);
-    updateADSR();
+    RealtimeGuard::prepare();
+
+    // a layout change always comes with a prepareToPlay, so this is the only place the buses are looked at
+    for (int bus = 1; bus < numOutputBuses; ++bus) {
+        auto* output = getBus(false, bus);
+        mSampler.setOutputBusChannel(bus, output != nullptr && output->isEnabled() ? output->getChannelIndexInProcessBlockBuffer(0) : -1);
+    }
+
+    mSampler.prepare(sampleRate, samplesPerBlock);
+    updateRenderThreads();
+    mTelemetry.prepare(sampleRate);
+    updateTargetSampleRate();
+
+    mPendingChanges.fetch_and(~(juce::uint32) (envelopeChanged | voiceSettingsChanged | filterChanged));
+    updateEnvelope();
+    updateVoiceSettings();
+    updateFilter();
 }
 
 void YellowRoseAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    mSampler.releaseResources();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -133,13 +212,40 @@ bool YellowRoseAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
         return false;
    #endif
 
+    // the extra outputs are stereo pairs, each either on or off
+    for (int bus = 1; bus < layouts.outputBuses.size(); ++bus)
+        if (!layouts.outputBuses[bus].isDisabled() && layouts.outputBuses[bus] != juce::AudioChannelSet::stereo())
+            return false;
+
     return true;
   #endif
 }
 #endif
 
+juce::AudioProcessor::BusesProperties YellowRoseAudioProcessor::createBusesProperties()
+{
+    BusesProperties buses;
+
+   #if ! JucePlugin_IsMidiEffect
+    #if ! JucePlugin_IsSynth
+    buses.addBus(true, "Input", juce::AudioChannelSet::stereo(), true);
+    #endif
+    buses.addBus(false, "Output", juce::AudioChannelSet::stereo(), true);
+
+    // off by default, so a host that doesn't ask for them sees a plain stereo instrument
+    for (int bus = 1; bus < numOutputBuses; ++bus)
+        buses.addBus(false, "Output " + juce::String(bus * 2 + 1) + "-" + juce::String(bus * 2 + 2),
+                     juce::AudioChannelSet::stereo(), false);
+   #endif
+
+    return buses;
+}
+
 void YellowRoseAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    const RealtimeGuard::ScopedRealtimeThread realtimeThread;
+    auto blockStart = juce::Time::getHighResolutionTicks();
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -147,12 +253,42 @@ void YellowRoseAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    if (mShouldUpdate) {
-        updateADSR();
-        mShouldUpdate = false;
+    // pick up a freshly loaded sound at the block boundary, the release pool
+    // still owns the old one so nothing gets deleted here
+    if (auto* sound = mPendingSound.exchange(nullptr)) {
+        mSampler.swapSound(sound);
+        sound->decReferenceCountWithoutDeleting();
     }
 
-    mSampler.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
+    auto changes = mPendingChanges.exchange(0);
+    auto numParameterChanges = mNumParameterChanges.exchange(0, std::memory_order_relaxed);
+
+    if (changes & envelopeChanged)
+        updateEnvelope();
+
+    if (changes & voiceSettingsChanged)
+        updateVoiceSettings();
+
+    if (changes & filterChanged)
+        updateFilter();
+
+    mSampler.renderBlock(buffer, midiMessages, 0, buffer.getNumSamples());
+
+    // two channels per voice, at the measured cost of the current interpolation
+    auto nanosecondsPerSecondOfAudio = mInterpolationCosts->get(mInterpolation) * 2.0 * getSampleRate();
+    mEstimatedVoiceLoad.store(mSampler.getNumActiveVoices() * nanosecondsPerSecondOfAudio * 1.0e-9, std::memory_order_relaxed);
+
+    mTelemetry.blockFinished(blockStart, buffer.getNumSamples(), mSampler.getNumActiveVoices(), numParameterChanges);
+}
+
+void YellowRoseAudioProcessor::setNonRealtime (bool isNonRealtime) noexcept
+{
+    juce::AudioProcessor::setNonRealtime(isNonRealtime);
+
+    // a bounce renders as fast as it can, a stream would underrun on every block
+    // and a progressive load would play silence where the decoder hasn't got to
+    mSampleLoader.setStreamingEnabled(!isNonRealtime);
+    mSampleLoader.setProgressiveLoading(!isNonRealtime);
 }
 
 //==============================================================================
@@ -169,64 +305,221 @@ juce::AudioProcessorEditor* YellowRoseAudioProcessor::createEditor()
 //==============================================================================
 void YellowRoseAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    auto state = mAPVTS.copyState();
+
+    {
+        const NonRealtimeLock::ScopedLockType sl(mLoadedSoundLock);
+
+        if (mSampleReference.file != juce::File()) {
+            juce::ValueTree sample("SAMPLE");
+            sample.setProperty("path", mSampleReference.file.getFullPathName(), nullptr);
+            sample.setProperty("hash", (juce::int64) mSampleReference.hash, nullptr);
+            state.appendChild(sample, nullptr);
+        }
+    }
+
+    // ValueTree's binary format, a few hundred bytes instead of the XML
+    juce::MemoryOutputStream stream(destData, false);
+    stream.writeInt(stateMagic);
+    stream.writeInt(stateVersion);
+    state.writeToStream(stream);
 }
 
 void YellowRoseAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    juce::MemoryInputStream stream(data, (size_t) juce::jmax(0, sizeInBytes), false);
+
+    if (sizeInBytes < 8 || stream.readInt() != stateMagic || stream.readInt() > stateVersion)
+        return;
+
+    auto state = juce::ValueTree::readFromStream(stream);
+
+    if (!state.hasType(mAPVTS.state.getType()))
+        return;
+
+    auto sample = state.getChildWithName("SAMPLE");
+    state.removeChild(sample, nullptr);
+    mAPVTS.replaceState(state);
+
+    // only the reference is restored here, the decode happens on the loader thread
+    if (sample.isValid())
+        requestSample(juce::File(sample["path"].toString()), (juce::uint64) (juce::int64) sample["hash"]);
 }
 
 void YellowRoseAudioProcessor::loadFile()
 {
-    mSampler.clearSounds();
-
     juce::FileChooser chooser{ "Please load a file" };
 
     if (chooser.browseForFileToOpen())
+        requestSample(chooser.getResult(), 0);
+}
+
+void YellowRoseAudioProcessor::loadFile(const juce::String& path)
+{
+    requestSample(juce::File(path), 0);
+}
+
+void YellowRoseAudioProcessor::requestSample(const juce::File& file, juce::uint64 expectedHash)
+{
     {
-        auto file = chooser.getResult();
-        mFormatReader = mFormatManager.createReaderFor(file);
+        const NonRealtimeLock::ScopedLockType sl(mLoadedSoundLock);
+
+        // recalling a state that plays what's already loaded costs nothing
+        if (expectedHash != 0 && mSampleReference.file == file && mSampleReference.hash == expectedHash)
+            return;
+
+        mSampleReference = { file, expectedHash };
+        mExpectedHash = expectedHash;
+        mSampleChanged = false;
     }
 
-    juce::BigInteger range;
-    range.setRange(0, 127, true);
-    mSampler.addSound(new juce::SamplerSound("Sample", *mFormatReader, range, 60, 0, 0, 60));
+    mSampleLoader.loadFile(file);
+}
+
+juce::SynthesiserSound::Ptr YellowRoseAudioProcessor::getLoadedSound() const
+{
+    const NonRealtimeLock::ScopedLockType sl(mLoadedSoundLock);
+    return mLoadedSound;
+}
 
-    updateADSR();
+bool YellowRoseAudioProcessor::isSampleLoaded() const
+{
+    const NonRealtimeLock::ScopedLockType sl(mLoadedSoundLock);
+    return mLoadedSound != nullptr && mLoadedFile == mSampleReference.file;
 }
 
-void YellowRoseAudioProcessor::loadFile(const juce::String& path)
+bool YellowRoseAudioProcessor::hasSampleChanged() const
+{
+    const NonRealtimeLock::ScopedLockType sl(mLoadedSoundLock);
+    return mSampleChanged;
+}
+
+int YellowRoseAudioProcessor::getVoicePositions(float* positions, int maxPositions) const
 {
-    mSampler.clearSounds();
+    auto numPositions = juce::jmin(maxPositions, mVoices.size());
 
-    auto file = juce::File(path);
-    mFormatReader = mFormatManager.createReaderFor(file);
+    for (int i = 0; i < numPositions; ++i)
+        positions[i] = mVoices.getUnchecked(i)->getDisplayPosition();
 
-    auto sampleLength = static_cast<int>(mFormatReader->lengthInSamples);
+    return numPositions;
+}
 
-    mWaveForm.setSize(1, sampleLength);
-    mFormatReader->read(&mWaveForm, 0, sampleLength, 0, true, false);
+void YellowRoseAudioProcessor::setResamplesOnLoad(bool shouldResample)
+{
+    mResamplesOnLoad = shouldResample;
 
-    juce::BigInteger range;
-    range.setRange(0, 127, true);
-    mSampler.addSound(new juce::SamplerSound("Sample", *mFormatReader, range, 60, 0, 0, 60));
+    // before the first prepareToPlay there's no host rate, it's picked up from there
+    if (mTargetSampleRate.load() >= 0.0)
+        updateTargetSampleRate();
 }
 
-void YellowRoseAudioProcessor::updateADSR() {
-    mADSRparams.attack = mAPVTS.getRawParameterValue("ATTACK")->load();
-    mADSRparams.decay = mAPVTS.getRawParameterValue("DECAY")->load();
-    mADSRparams.sustain = mAPVTS.getRawParameterValue("SUSTAIN")->load();
-    mADSRparams.release = mAPVTS.getRawParameterValue("RELEASE")->load();
+void YellowRoseAudioProcessor::updateTargetSampleRate()
+{
+    auto rate = mResamplesOnLoad ? getSampleRate() : 0.0;
+    mSampleLoader.setTargetSampleRate(rate);
+
+    // the first time, whatever was loaded at its own rate plays fine and the next load converts.
+    // A recalled session would otherwise be decoded twice when the host starts.
+    auto previousRate = mTargetSampleRate.exchange(rate);
+
+    if (previousRate < 0.0 || previousRate == rate)
+        return;
+
+    SampleLoader::SampleReference reference;
+
+    {
+        const NonRealtimeLock::ScopedLockType sl(mLoadedSoundLock);
+        reference = mSampleReference;
+    }
+
+    // what's loaded was converted for the old rate, or not at all
+    if (reference.file != juce::File())
+        mSampleLoader.loadFile(reference.file);
+}
 
-    for (int i = 0; i < mSampler.getNumSounds(); i++) {
-        if (auto sound = dynamic_cast<juce::SamplerSound*>(mSampler.getSound(i).get())) {
-            sound->setEnvelopeParameters(mADSRparams);
+void YellowRoseAudioProcessor::soundLoaded(juce::SynthesiserSound::Ptr sound, const SampleLoader::SampleReference& reference)
+{
+    // called on the loader thread
+    mReleasePool.add(sound.get());
+
+    {
+        const NonRealtimeLock::ScopedLockType sl(mLoadedSoundLock);
+        mLoadedSound = sound;
+        mLoadedFile = reference.file;
+
+        // a newer request may already be on its way, that one stays the reference
+        if (mSampleReference.file == reference.file) {
+            mSampleReference.hash = reference.hash;
+            mSampleChanged = mExpectedHash != 0 && reference.hash != mExpectedHash;
         }
     }
+
+    // copies of the old sound would only hold on to it, notes still playing them keep theirs
+    mPitchCache.clear();
+
+    sound->incReferenceCount();
+
+    // a sound that was never picked up by the audio thread is simply dropped
+    if (auto* previous = mPendingSound.exchange(sound.get()))
+        previous->decReferenceCountWithoutDeleting();
+
+    sendChangeMessage();
+}
+
+void YellowRoseAudioProcessor::updateEnvelope() {
+    mADSRparams.attack = mAttack->load();
+    mADSRparams.decay = mDecay->load();
+    mADSRparams.sustain = mSustain->load();
+    mADSRparams.release = mRelease->load();
+
+    // the voices smooth the change themselves, notes that are playing pick it up too
+    for (auto* voice : mVoices)
+        voice->setEnvelopeParameters(mADSRparams);
+}
+
+void YellowRoseAudioProcessor::updateVoiceSettings() {
+    mInterpolation = (InterpolationMode) (int) mQuality->load();
+
+    for (auto* voice : mSampleVoices)
+        voice->setInterpolation(mInterpolation);
+
+    mSampler.setPolyphony((int) mPolyphony->load());
+    mSampler.setStealingPolicy((YellowRoseSynth::StealingPolicy) (int) mStealing->load());
+    mSampler.setMultithreaded(mMulticore->load() > 0.5f);
+    mPitchCache.setEnabled(mPitchCacheEnabled->load() > 0.5f);
+}
+
+void YellowRoseAudioProcessor::updateFilter() {
+    VoiceFilter::Settings settings;
+    settings.type = (FilterType) (int) mFilterType->load();
+    settings.cutoffHz = mCutoff->load();
+    settings.resonance = mResonance->load();
+    settings.envelopeOctaves = mFilterEnvelopeAmount->load();
+    settings.keyTracking = mKeyTracking->load();
+    mSampler.setFilterSettings(settings);
+
+    juce::ADSR::Parameters envelope;
+    envelope.attack = mFilterAttack->load();
+    envelope.decay = mFilterDecay->load();
+    envelope.sustain = mFilterSustain->load();
+    envelope.release = mFilterRelease->load();
+
+    for (auto* voice : mVoices)
+        voice->setFilterEnvelopeParameters(envelope);
+}
+
+void YellowRoseAudioProcessor::updateRenderThreads() {
+    mSampler.setRenderThreadsRunning(mMulticore->load() > 0.5f);
+}
+
+void YellowRoseAudioProcessor::updateLoopSettings() {
+    LoopSettings settings;
+    settings.mode = (LoopMode) (int) mLoopMode->load();
+    settings.start = mLoopStart->load();
+    settings.end = mLoopEnd->load();
+    settings.crossfadeMs = mLoopCrossfade->load();
+
+    mSampleLoader.setLoopSettings(settings);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout YellowRoseAudioProcessor::createParameters() {
@@ -236,14 +529,28 @@ juce::AudioProcessorValueTreeState::ParameterLayout YellowRoseAudioProcessor::cr
     parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("DECAY", "Decay", 0.0f, 10.0f, 1.0f));
     parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("SUSTAIN", "Sustain", 0.0f, 1.0f, 1.0f));
     parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("RELEASE", "Release", 0.0f, 5.0f, 0.5f));
+    parameters.push_back(std::make_unique < juce::AudioParameterChoice > ("QUALITY", "Quality", Interpolator::getModeNames(), (int) InterpolationMode::cubic));
+    parameters.push_back(std::make_unique < juce::AudioParameterInt > ("POLYPHONY", "Polyphony", 1, maxPolyphony, 16));
+    parameters.push_back(std::make_unique < juce::AudioParameterChoice > ("STEALING", "Voice Stealing", YellowRoseSynth::getStealingPolicyNames(), (int) YellowRoseSynth::StealingPolicy::oldest));
+    parameters.push_back(std::make_unique < juce::AudioParameterBool > ("MULTICORE", "Multicore", false));
+    parameters.push_back(std::make_unique < juce::AudioParameterBool > ("PITCHCACHE", "One-shot Cache", false));
+    parameters.push_back(std::make_unique < juce::AudioParameterChoice > ("LOOPMODE", "Loop", LoopSettings::getModeNames(), (int) LoopMode::off));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("LOOPSTART", "Loop Start", 0.0f, 1.0f, LoopSettings{}.start));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("LOOPEND", "Loop End", 0.0f, 1.0f, LoopSettings{}.end));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("LOOPXFADE", "Loop Crossfade", 0.0f, 500.0f, LoopSettings{}.crossfadeMs));
+    parameters.push_back(std::make_unique < juce::AudioParameterChoice > ("FILTERTYPE", "Filter", VoiceFilter::getTypeNames(), (int) FilterType::off));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("CUTOFF", "Cutoff", juce::NormalisableRange<float>(20.0f, 20000.0f, 0.0f, 0.25f), 20000.0f));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("RESONANCE", "Resonance", juce::NormalisableRange<float>(0.5f, 10.0f, 0.0f, 0.5f), 0.7071f));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("FILTERENV", "Filter Envelope", -8.0f, 8.0f, 0.0f));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("KEYTRACK", "Key Tracking", 0.0f, 1.0f, 0.0f));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("FATTACK", "Filter Attack", 0.0f, 10.0f, 0.0f));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("FDECAY", "Filter Decay", 0.0f, 10.0f, 1.0f));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("FSUSTAIN", "Filter Sustain", 0.0f, 1.0f, 1.0f));
+    parameters.push_back(std::make_unique < juce::AudioParameterFloat > ("FRELEASE", "Filter Release", 0.0f, 5.0f, 0.5f));
 
     return { parameters.begin(), parameters.end() };
 }
 
-void YellowRoseAudioProcessor::valueTreePropertyChanged(juce::ValueTree& treeWhosePropertyHasChanged, const juce::Identifier& property) {
-    mShouldUpdate = true;
-}
-
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
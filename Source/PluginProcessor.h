@@ -9,13 +9,32 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "YellowRoseSynth.h"
+#include "SampleLoader.h"
+#include "DiskStreamer.h"
+#include "ReleasePool.h"
+#include "Interpolator.h"
+#include "PitchCache.h"
+#include "Telemetry.h"
+#include "RealtimeGuard.h"
+
+class SampleVoice;
+class YellowRoseVoice;
 
 //==============================================================================
 /**
 */
-class YellowRoseAudioProcessor  : public juce::AudioProcessor, public juce::ValueTree::Listener
+class YellowRoseAudioProcessor  : public juce::AudioProcessor, public juce::ChangeBroadcaster
 {
 public:
+    static constexpr int maxPolyphony = 128;
+
+    // streaming voices each own a disk ring, so there are fewer of them
+    static constexpr int numStreamingVoices = 16;
+
+    // the main output and seven more stereo pairs, which the host can turn on
+    static constexpr int numOutputBuses = YellowRoseSynth::maxOutputBuses;
+
     //==============================================================================
     YellowRoseAudioProcessor();
     ~YellowRoseAudioProcessor() override;
@@ -30,6 +49,9 @@ public:
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
+    /** Offline, long samples are decoded whole from the next load on instead of streamed. */
+    void setNonRealtime (bool isNonRealtime) noexcept override;
+
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -57,27 +79,199 @@ public:
     void loadFile(const juce::String& path);
 
     int getNumSamplerSounds() { return mSampler.getNumSounds(); }
-    juce::AudioBuffer<float>& getWaveForm() { return mWaveForm; }
+    juce::SynthesiserSound::Ptr getLoadedSound() const;
+
+    /** Whether the sound for the last file asked for has loaded, not just an earlier one. */
+    bool isSampleLoaded() const;
+
+    /** Whether the loaded sample is no longer what the recalled session saved: same
+        file, different contents. Change messages are sent when it's known.
+    */
+    bool hasSampleChanged() const;
+
+    int getNumStreamUnderruns() const { return mDiskStreamer.getNumUnderruns(); }
+
+    /** Measured once per process in the background, in nanoseconds per frame and channel
+        of one voice. 0 until the measurement is done.
+    */
+    double getInterpolationCost(InterpolationMode mode) const { return mInterpolationCosts->get(mode); }
+
+    int getNumActiveVoices() const { return mSampler.getNumActiveVoices(); }
+
+    /** Fills in where each voice is in its sample, -1 for the idle ones, and returns how many
+        there are. Never waits for the audio thread.
+    */
+    int getVoicePositions(float* positions, int maxPositions) const;
 
-    void updateADSR();
+    LoopSettings getLoopSettings() const { return mSampleLoader.getLoopSettings(); }
+    VoiceRenderPool::Stats getRenderPoolStats() const { return mSampler.getRenderPoolStats(); }
+
+    /** Whether samples are converted to the host rate when they're loaded. Message thread. */
+    void setResamplesOnLoad(bool shouldResample);
+
+    /** Whether decoded samples go through the on-disk cache, from the next load on. */
+    void setUsesSampleCache(bool shouldUse) { mSampleLoader.setUsesSampleCache(shouldUse); }
+
+    /** For the benchmarks, see YellowRoseSynth::setUsesVoiceBank(). */
+    void setUsesVoiceBank(bool shouldUse) { mSampler.setUsesVoiceBank(shouldUse); }
+
+    /** Share of real time the active voices are expected to take, from the measured interpolation cost. */
+    double getEstimatedVoiceLoad() const { return mEstimatedVoiceLoad.load(std::memory_order_relaxed); }
+
+    /** What the last blocks took, from one thread at a time. Never waits for the audio thread. */
+    Telemetry::Snapshot getTelemetry() { return mTelemetry.getSnapshot(); }
+    void resetTelemetry() { mTelemetry.reset(); }
 
     juce::ADSR::Parameters& getADSRparams() { return mADSRparams; }
     juce::AudioProcessorValueTreeState& getAPVTS() { return mAPVTS; }
 
 private:
-    juce::Synthesiser mSampler;
-    const int mNumVoices{ 3 };
-    juce::AudioBuffer<float> mWaveForm;
+    DiskStreamer mDiskStreamer;
+
+    // before the sampler, the voices hand their cache entries back when they're destroyed
+    PitchCache mPitchCache;
+    YellowRoseSynth mSampler;
 
     juce::ADSR::Parameters mADSRparams;
 
-    juce::AudioFormatManager mFormatManager;
-    juce::AudioFormatReader* mFormatReader{ nullptr };
+    juce::Array<YellowRoseVoice*> mVoices;
+    juce::Array<SampleVoice*> mSampleVoices;
+    juce::SharedResourcePointer<InterpolationCosts> mInterpolationCosts;
+    InterpolationMode mInterpolation{ InterpolationMode::cubic };
+    std::atomic<double> mEstimatedVoiceLoad{ 0.0 };
+    Telemetry mTelemetry;
+
+    void soundLoaded(juce::SynthesiserSound::Ptr sound, const SampleLoader::SampleReference& reference);
+    void requestSample(const juce::File& file, juce::uint64 expectedHash);
+    void updateTargetSampleRate();
+
+    ReleasePool mReleasePool;
+    SampleLoader mSampleLoader{ mDiskStreamer };
+
+    // handed from the loader thread to the audio thread, holds one reference
+    std::atomic<juce::SynthesiserSound*> mPendingSound{ nullptr };
+
+    juce::SynthesiserSound::Ptr mLoadedSound;
+    juce::File mLoadedFile;
+    NonRealtimeLock mLoadedSoundLock;
+
+    // the last sample asked for, which is what the state refers to even before it has loaded
+    SampleLoader::SampleReference mSampleReference;
+
+    // the hash the recalled state asked for, 0 for a file picked by hand
+    juce::uint64 mExpectedHash{ 0 };
+    bool mSampleChanged{ false };
+
+    // set from the message thread, read by prepareToPlay on whichever thread the host calls it.
+    // The target rate is negative until the first prepareToPlay.
+    std::atomic<bool> mResamplesOnLoad{ true };
+    std::atomic<double> mTargetSampleRate{ -1.0 };
+
+    // "YRST", then a version and the parameter tree with a SAMPLE child
+    static constexpr int stateMagic = 0x54535259;
+    static constexpr int stateVersion = 1;
 
     juce::AudioProcessorValueTreeState mAPVTS;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
-    void valueTreePropertyChanged(juce::ValueTree &treeWhosePropertyHasChanged, const juce::Identifier &property) override;
-    std::atomic<bool> mShouldUpdate{ false };
+    static BusesProperties createBusesProperties();
+
+    // looked up once, the audio thread only ever loads through these
+    std::atomic<float>* mAttack{ nullptr };
+    std::atomic<float>* mDecay{ nullptr };
+    std::atomic<float>* mSustain{ nullptr };
+    std::atomic<float>* mRelease{ nullptr };
+    std::atomic<float>* mQuality{ nullptr };
+    std::atomic<float>* mPolyphony{ nullptr };
+    std::atomic<float>* mStealing{ nullptr };
+    std::atomic<float>* mMulticore{ nullptr };
+    std::atomic<float>* mPitchCacheEnabled{ nullptr };
+    std::atomic<float>* mLoopMode{ nullptr };
+    std::atomic<float>* mLoopStart{ nullptr };
+    std::atomic<float>* mLoopEnd{ nullptr };
+    std::atomic<float>* mLoopCrossfade{ nullptr };
+    std::atomic<float>* mFilterType{ nullptr };
+    std::atomic<float>* mCutoff{ nullptr };
+    std::atomic<float>* mResonance{ nullptr };
+    std::atomic<float>* mFilterEnvelopeAmount{ nullptr };
+    std::atomic<float>* mKeyTracking{ nullptr };
+    std::atomic<float>* mFilterAttack{ nullptr };
+    std::atomic<float>* mFilterDecay{ nullptr };
+    std::atomic<float>* mFilterSustain{ nullptr };
+    std::atomic<float>* mFilterRelease{ nullptr };
+
+    enum ChangeBits : juce::uint32
+    {
+        envelopeChanged = 1 << 0,
+        voiceSettingsChanged = 1 << 1,
+        filterChanged = 1 << 2
+    };
+
+    // sets its bit whenever one of its parameters changes, on whichever thread that happens,
+    // and counts the change for the telemetry
+    struct ChangeFlag  : public juce::AudioProcessorValueTreeState::Listener
+    {
+        ChangeFlag(std::atomic<juce::uint32>& flags, std::atomic<int>& count, juce::uint32 bit) : mFlags(flags), mCount(count), mBit(bit) {}
+
+        void parameterChanged(const juce::String&, float) override
+        {
+            mFlags.fetch_or(mBit);
+            mCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::atomic<juce::uint32>& mFlags;
+        std::atomic<int>& mCount;
+        const juce::uint32 mBit;
+    };
+
+    // the audio thread takes all pending changes at once at the start of a block
+    std::atomic<juce::uint32> mPendingChanges{ envelopeChanged | voiceSettingsChanged | filterChanged };
+    std::atomic<int> mNumParameterChanges{ 0 };
+    ChangeFlag mEnvelopeFlag{ mPendingChanges, mNumParameterChanges, envelopeChanged };
+    ChangeFlag mVoiceSettingsFlag{ mPendingChanges, mNumParameterChanges, voiceSettingsChanged };
+    ChangeFlag mFilterFlag{ mPendingChanges, mNumParameterChanges, filterChanged };
+
+    // loops are built by the loader, which only stores the settings wherever they change
+    struct LoopListener  : public juce::AudioProcessorValueTreeState::Listener
+    {
+        LoopListener(YellowRoseAudioProcessor& owner) : mOwner(owner) {}
+
+        void parameterChanged(const juce::String&, float) override { mOwner.updateLoopSettings(); }
+
+        YellowRoseAudioProcessor& mOwner;
+    };
+
+    LoopListener mLoopListener{ *this };
+
+    // the render threads only exist while MULTICORE is on. Starting them can't happen on the
+    // audio thread, so a change from there is passed on to the message thread.
+    struct MulticoreListener  : public juce::AudioProcessorValueTreeState::Listener, public juce::AsyncUpdater
+    {
+        MulticoreListener(YellowRoseAudioProcessor& owner) : mOwner(owner) {}
+
+        void parameterChanged(const juce::String&, float) override
+        {
+            if (juce::MessageManager::existsAndIsCurrentThread()) {
+                mOwner.updateRenderThreads();
+                return;
+            }
+
+            // posting takes the message queue's lock, hosts hardly ever automate this from the audio thread
+            const RealtimeGuard::ScopedAllowance allowance;
+            triggerAsyncUpdate();
+        }
+
+        void handleAsyncUpdate() override { mOwner.updateRenderThreads(); }
+
+        YellowRoseAudioProcessor& mOwner;
+    };
+
+    MulticoreListener mMulticoreListener{ *this };
+
+    void updateEnvelope();
+    void updateVoiceSettings();
+    void updateFilter();
+    void updateLoopSettings();
+    void updateRenderThreads();
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (YellowRoseAudioProcessor)
@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.cpp
+    Created: 1 Mar 2025 9:26:31am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "RealtimeGuard.h"
+
+#if YELLOWROSE_REALTIME_TRAP && JUCE_WINDOWS && defined (_DEBUG)
+ #include <crtdbg.h>
+#endif
+
+namespace
+{
+    // how deep the thread is in real-time scopes, and in allowances
+    thread_local int realtimeDepth = 0;
+    thread_local int allowanceDepth = 0;
+
+    std::atomic<int> numViolations{ 0 };
+    std::atomic<const char*> lastViolation{ nullptr };
+    std::atomic<bool> abortsOnViolation{ false };
+    std::atomic<bool> isUnderDebugger{ false };
+}
+
+//==============================================================================
+RealtimeGuard::ScopedRealtimeThread::ScopedRealtimeThread() noexcept  { ++realtimeDepth; }
+RealtimeGuard::ScopedRealtimeThread::~ScopedRealtimeThread() noexcept { --realtimeDepth; }
+
+RealtimeGuard::ScopedAllowance::ScopedAllowance() noexcept  { ++allowanceDepth; }
+RealtimeGuard::ScopedAllowance::~ScopedAllowance() noexcept { --allowanceDepth; }
+
+bool RealtimeGuard::isTrapping() noexcept
+{
+    return realtimeDepth > 0 && allowanceDepth == 0;
+}
+
+void RealtimeGuard::violation(const char* what) noexcept
+{
+    numViolations.fetch_add(1, std::memory_order_relaxed);
+    lastViolation.store(what, std::memory_order_relaxed);
+
+    if (abortsOnViolation.load(std::memory_order_relaxed))
+        std::abort();
+
+    // not a jassert, logging it would allocate inside the allocator
+    if (isUnderDebugger.load(std::memory_order_relaxed))
+        JUCE_BREAK_IN_DEBUGGER;
+}
+
+void RealtimeGuard::prepare()
+{
+    isUnderDebugger = juce::juce_isRunningUnderDebugger();
+}
+
+int RealtimeGuard::getNumViolations() noexcept            { return numViolations.load(); }
+const char* RealtimeGuard::getLastViolation() noexcept    { return lastViolation.load(); }
+void RealtimeGuard::setAbortsOnViolation(bool shouldAbort) noexcept { abortsOnViolation = shouldAbort; }
+
+//==============================================================================
+#if YELLOWROSE_REALTIME_TRAP
+
+#if JUCE_WINDOWS && defined (_DEBUG)
+
+namespace
+{
+    int __cdecl allocationHook(int allocationType, void*, size_t, int blockType, long, const unsigned char*, int)
+    {
+        // the CRT's own bookkeeping isn't ours to judge
+        if (blockType != _CRT_BLOCK && RealtimeGuard::isTrapping())
+            RealtimeGuard::violation(allocationType == _HOOK_FREE ? "free" : allocationType == _HOOK_REALLOC ? "realloc" : "malloc");
+
+        return TRUE;
+    }
+
+    // installed before anything of ours runs
+    const struct AllocationHookInstaller
+    {
+        AllocationHookInstaller() { _CrtSetAllocHook(allocationHook); }
+    } allocationHookInstaller;
+}
+
+#elif YELLOWROSE_REPLACE_OPERATOR_NEW
+
+#if YELLOWROSE_WRAP_ALLOCATOR
+extern "C"
+{
+    void* __real_malloc(size_t);
+    void __real_free(void*);
+}
+#endif
+
+namespace
+{
+    // past the wrappers, so a new on the audio thread is reported once, as itself
+    void* allocate(std::size_t size) noexcept
+    {
+       #if YELLOWROSE_WRAP_ALLOCATOR
+        return __real_malloc(size > 0 ? size : 1);
+       #else
+        return std::malloc(size > 0 ? size : 1);
+       #endif
+    }
+
+    void deallocate(void* memory) noexcept
+    {
+       #if YELLOWROSE_WRAP_ALLOCATOR
+        __real_free(memory);
+       #else
+        std::free(memory);
+       #endif
+    }
+}
+
+// the replaceable global forms, the aligned ones are left to the library
+void* operator new(std::size_t size)
+{
+    if (RealtimeGuard::isTrapping())
+        RealtimeGuard::violation("operator new");
+
+    if (auto* memory = allocate(size))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    if (RealtimeGuard::isTrapping())
+        RealtimeGuard::violation("operator new");
+
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)                               { return operator new(size); }
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void* memory) noexcept
+{
+    if (memory != nullptr && RealtimeGuard::isTrapping())
+        RealtimeGuard::violation("operator delete");
+
+    deallocate(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept   { operator delete(memory); }
+void operator delete(void* memory, std::size_t) noexcept             { operator delete(memory); }
+void operator delete[](void* memory) noexcept                        { operator delete(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { operator delete(memory); }
+void operator delete[](void* memory, std::size_t) noexcept           { operator delete(memory); }
+
+#endif
+
+#if YELLOWROSE_WRAP_ALLOCATOR
+#include <pthread.h>
+
+// the linker sends the calls made from our own objects here, see the CMake build of
+// the tools. Calls from inside shared libraries aren't, libstdc++'s operator new among
+// them, which is why it's still replaced above.
+extern "C"
+{
+    void* __real_malloc(size_t);
+    void* __real_calloc(size_t, size_t);
+    void* __real_realloc(void*, size_t);
+    void __real_free(void*);
+    int __real_pthread_mutex_lock(pthread_mutex_t*);
+
+    void* __wrap_malloc(size_t size)
+    {
+        if (RealtimeGuard::isTrapping())
+            RealtimeGuard::violation("malloc");
+
+        return __real_malloc(size);
+    }
+
+    void* __wrap_calloc(size_t count, size_t size)
+    {
+        if (RealtimeGuard::isTrapping())
+            RealtimeGuard::violation("calloc");
+
+        return __real_calloc(count, size);
+    }
+
+    void* __wrap_realloc(void* memory, size_t size)
+    {
+        if (RealtimeGuard::isTrapping())
+            RealtimeGuard::violation("realloc");
+
+        return __real_realloc(memory, size);
+    }
+
+    void __wrap_free(void* memory)
+    {
+        if (memory != nullptr && RealtimeGuard::isTrapping())
+            RealtimeGuard::violation("free");
+
+        __real_free(memory);
+    }
+
+    int __wrap_pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        if (RealtimeGuard::isTrapping())
+            RealtimeGuard::violation("pthread_mutex_lock");
+
+        return __real_pthread_mutex_lock(mutex);
+    }
+}
+#endif
+
+#endif
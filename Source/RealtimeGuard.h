@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.h
+    Created: 1 Mar 2025 9:26:31am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// on in debug builds unless the build says otherwise
+#ifndef YELLOWROSE_REALTIME_TRAP
+ #define YELLOWROSE_REALTIME_TRAP JUCE_DEBUG
+#endif
+
+// only for executables. A plugin that replaced the global operator new would replace
+// it for the whole host on platforms that bind symbols process-wide
+#ifndef YELLOWROSE_REPLACE_OPERATOR_NEW
+ #define YELLOWROSE_REPLACE_OPERATOR_NEW 0
+#endif
+
+//==============================================================================
+/*
+    Traps allocations and locks on the audio thread, in builds with
+    YELLOWROSE_REALTIME_TRAP on.
+
+    processBlock and the voice workers mark their thread as real-time while they
+    run. On such a thread, each of the following counts as a violation:
+
+    - Windows debug builds: any malloc, realloc or free, through the debug CRT's
+      allocation hook.
+    - Elsewhere, in executables built with YELLOWROSE_REPLACE_OPERATOR_NEW:
+      operator new and delete. The console tools are built this way, the plugin
+      isn't, since it shares its process with the host.
+    - Executables linked with --wrap for malloc, calloc, realloc, free and
+      pthread_mutex_lock (YELLOWROSE_WRAP_ALLOCATOR): those calls as well, when
+      they're made from our own code, which covers every juce::CriticalSection
+      and std::mutex. The console tools' debug builds are linked this way.
+    - Everywhere: taking a NonRealtimeLock. The plugin's own locks are all this type.
+
+    A violation is counted and breaks into the debugger, or aborts if that's been
+    asked for, so real-time safety is tested on every debug run.
+
+    The few calls that are known to lock and are accepted, such as posting a
+    MULTICORE change to the message thread, sit inside a ScopedAllowance.
+*/
+struct RealtimeGuard
+{
+    /** Marks the calling thread as real-time while it exists. Nests. */
+    class ScopedRealtimeThread
+    {
+    public:
+        ScopedRealtimeThread() noexcept;
+        ~ScopedRealtimeThread() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeThread)
+    };
+
+    /** Lets a real-time thread allocate and lock while it exists. */
+    class ScopedAllowance
+    {
+    public:
+        ScopedAllowance() noexcept;
+        ~ScopedAllowance() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedAllowance)
+    };
+
+    /** Looks up whether there's a debugger to break into. Not on the audio thread. */
+    static void prepare();
+
+    /** Whether the calling thread is real-time and not inside an allowance. */
+    static bool isTrapping() noexcept;
+
+    /** Called by the hooks, what names the call that did it. */
+    static void violation(const char* what) noexcept;
+
+    static int getNumViolations() noexcept;
+
+    /** The last call that was trapped, or null. */
+    static const char* getLastViolation() noexcept;
+
+    /** Aborts on a violation instead of only breaking into the debugger, for test runs. */
+    static void setAbortsOnViolation(bool shouldAbort) noexcept;
+
+    static void lockTaken() noexcept
+    {
+       #if YELLOWROSE_REALTIME_TRAP
+        if (isTrapping())
+            violation("lock");
+       #endif
+    }
+};
+
+//==============================================================================
+/** A CriticalSection that's a violation to take on a real-time thread. */
+class NonRealtimeLock
+{
+public:
+    void enter() const noexcept   { RealtimeGuard::lockTaken(); mLock.enter(); }
+    bool tryEnter() const noexcept { RealtimeGuard::lockTaken(); return mLock.tryEnter(); }
+    void exit() const noexcept    { mLock.exit(); }
+
+    using ScopedLockType = juce::GenericScopedLock<NonRealtimeLock>;
+
+private:
+    juce::CriticalSection mLock;
+};
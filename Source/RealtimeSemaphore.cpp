@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    RealtimeSemaphore.cpp
+    Created: 29 Mar 2025 10:14:52am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "RealtimeSemaphore.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+ #include <ctime>
+#endif
+
+#if JUCE_WINDOWS
+
+struct RealtimeSemaphore::Native
+{
+    Native() : handle(CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr)) {}
+    ~Native() { CloseHandle(handle); }
+
+    void post() noexcept { ReleaseSemaphore(handle, 1, nullptr); }
+
+    bool wait(int timeoutMs) noexcept
+    {
+        return WaitForSingleObject(handle, timeoutMs < 0 ? INFINITE : (DWORD) timeoutMs) == WAIT_OBJECT_0;
+    }
+
+    HANDLE handle;
+};
+
+#elif JUCE_MAC || JUCE_IOS
+
+struct RealtimeSemaphore::Native
+{
+    Native() : semaphore(dispatch_semaphore_create(0)) {}
+    ~Native() { dispatch_release(semaphore); }
+
+    void post() noexcept { dispatch_semaphore_signal(semaphore); }
+
+    bool wait(int timeoutMs) noexcept
+    {
+        auto timeout = timeoutMs < 0 ? DISPATCH_TIME_FOREVER : dispatch_time(DISPATCH_TIME_NOW, (int64_t) timeoutMs * 1000000);
+        return dispatch_semaphore_wait(semaphore, timeout) == 0;
+    }
+
+    dispatch_semaphore_t semaphore;
+};
+
+#else
+
+struct RealtimeSemaphore::Native
+{
+    Native() { sem_init(&semaphore, 0, 0); }
+    ~Native() { sem_destroy(&semaphore); }
+
+    // a futex wake, and async-signal-safe, so it doesn't lock anything
+    void post() noexcept { sem_post(&semaphore); }
+
+    bool wait(int timeoutMs) noexcept
+    {
+        if (timeoutMs < 0) {
+            while (sem_wait(&semaphore) != 0)
+                if (errno != EINTR)
+                    return false;
+
+            return true;
+        }
+
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeoutMs / 1000;
+        deadline.tv_nsec += (long) (timeoutMs % 1000) * 1000000;
+
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        while (sem_timedwait(&semaphore, &deadline) != 0)
+            if (errno != EINTR)
+                return false;
+
+        return true;
+    }
+
+    sem_t semaphore;
+};
+
+#endif
+
+//==============================================================================
+RealtimeSemaphore::RealtimeSemaphore() : mNative(std::make_unique<Native>())
+{
+}
+
+RealtimeSemaphore::~RealtimeSemaphore() = default;
+
+void RealtimeSemaphore::signal() noexcept
+{
+    // below zero means someone is waiting on the OS semaphore for this
+    if (mCount.fetch_add(1, std::memory_order_release) < 0)
+        mNative->post();
+}
+
+bool RealtimeSemaphore::wait(int timeoutMs) noexcept
+{
+    if (mCount.fetch_sub(1, std::memory_order_acquire) > 0)
+        return true;
+
+    return waitForNative(timeoutMs);
+}
+
+bool RealtimeSemaphore::waitForNative(int timeoutMs) noexcept
+{
+    if (mNative->wait(timeoutMs))
+        return true;
+
+    // timed out, so take back our place in the count. If a signal has already seen it
+    // and posted, that post is ours and has to be taken, or the next wait would get it.
+    auto count = mCount.load(std::memory_order_relaxed);
+
+    while (count < 0)
+        if (mCount.compare_exchange_weak(count, count + 1, std::memory_order_relaxed))
+            return false;
+
+    mNative->wait(-1);
+    return true;
+}
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    RealtimeSemaphore.h
+    Created: 29 Mar 2025 10:14:52am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    A counting semaphore that can be signalled from the audio thread.
+
+    The count lives in an atomic, so signal() is a single atomic add unless a
+    thread is actually waiting. Only then does it post the OS semaphore, which
+    is a futex, a dispatch semaphore or a Win32 semaphore, none of them with a
+    user-space mutex in front. juce::WaitableEvent locks a mutex to signal.
+*/
+class RealtimeSemaphore
+{
+public:
+    RealtimeSemaphore();
+    ~RealtimeSemaphore();
+
+    /** Lets one wait() through, now or the next time one is called. Never blocks. */
+    void signal() noexcept;
+
+    /** Returns true once signalled, or false after timeoutMs. Waits for ever with -1. */
+    bool wait(int timeoutMs) noexcept;
+
+private:
+    struct Native;
+
+    bool waitForNative(int timeoutMs) noexcept;
+
+    // signals not yet taken, or minus the number of threads waiting
+    std::atomic<int> mCount{ 0 };
+    std::unique_ptr<Native> mNative;
+
+    JUCE_DECLARE_NON_COPYABLE (RealtimeSemaphore)
+};
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    ReleasePool.cpp
+    Created: 2 Nov 2024 7:41:12pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "ReleasePool.h"
+
+ReleasePool::ReleasePool()
+{
+    startTimer(1000);
+}
+
+ReleasePool::~ReleasePool()
+{
+    stopTimer();
+}
+
+void ReleasePool::add(juce::ReferenceCountedObject* object)
+{
+    if (object == nullptr)
+        return;
+
+    const NonRealtimeLock::ScopedLockType sl(mLock);
+
+    if (!mObjects.contains(object))
+        mObjects.add(object);
+}
+
+void ReleasePool::releaseUnused()
+{
+    juce::ReferenceCountedArray<juce::ReferenceCountedObject> unused;
+
+    {
+        const NonRealtimeLock::ScopedLockType sl(mLock);
+
+        for (int i = mObjects.size(); --i >= 0;) {
+            if (mObjects.getObjectPointerUnchecked(i)->getReferenceCount() == 1)
+                unused.add(mObjects.removeAndReturn(i));
+        }
+    }
+
+    // the destructors run here, outside the lock
+}
+
+void ReleasePool::timerCallback()
+{
+    releaseUnused();
+}
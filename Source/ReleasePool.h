@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    ReleasePool.h
+    Created: 2 Nov 2024 7:41:12pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RealtimeGuard.h"
+
+//==============================================================================
+/*
+    Keeps an extra reference to every object that is handed to the audio thread,
+    so the audio thread only ever drops a reference and never runs a destructor.
+    Objects nobody else is holding any more are deleted from the message thread.
+*/
+class ReleasePool  : private juce::Timer
+{
+public:
+    ReleasePool();
+    ~ReleasePool() override;
+
+    void add(juce::ReferenceCountedObject* object);
+
+    /** Deletes everything that is only referenced by the pool. */
+    void releaseUnused();
+
+private:
+    void timerCallback() override;
+
+    juce::ReferenceCountedArray<juce::ReferenceCountedObject> mObjects;
+    NonRealtimeLock mLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReleasePool)
+};
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    Resampler.cpp
+    Created: 25 Jan 2025 1:36:48pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "Resampler.h"
+
+namespace
+{
+    constexpr double kaiserBeta = 10.0;
+
+    // keeps the transition band clear of the new Nyquist
+    constexpr double passband = 0.96;
+
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 32; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+
+        return sum;
+    }
+}
+
+SampleData::Ptr Resampler::process(const SampleData& source, double targetRate, const ParallelFor& parallelFor)
+{
+    auto view = source.getView();
+
+    // source frames per output frame
+    auto step = view.sampleRate / targetRate;
+    auto numOutputFrames = (int) juce::jmin(std::ceil(view.numFrames / step),
+                                            (double) std::numeric_limits<int>::max() - 2 * SampleData::paddingFrames);
+
+    auto cutoff = juce::jmin(1.0, 1.0 / step) * passband;
+    auto halfTaps = (int) std::ceil(zeroCrossings / cutoff);
+    auto numTaps = halfTaps * 2;
+
+    // one row of taps per phase, plus one so the last phase can be interpolated too
+    std::vector<float> table((size_t) (numPhases + 1) * (size_t) numTaps);
+    auto windowNorm = besselI0(kaiserBeta);
+
+    for (int phase = 0; phase <= numPhases; ++phase) {
+        auto fraction = (double) phase / numPhases;
+        auto* row = table.data() + (size_t) phase * (size_t) numTaps;
+        double sum = 0.0;
+
+        for (int tap = 0; tap < numTaps; ++tap) {
+            auto x = (double) (tap - (halfTaps - 1)) - fraction;
+            auto arg = juce::MathConstants<double>::pi * cutoff * x;
+            auto sinc = x == 0.0 ? 1.0 : std::sin(arg) / arg;
+
+            auto r = x / halfTaps;
+            auto window = std::abs(r) < 1.0 ? besselI0(kaiserBeta * std::sqrt(1.0 - r * r)) / windowNorm : 0.0;
+
+            row[tap] = (float) (sinc * window);
+            sum += row[tap];
+        }
+
+        // unity gain at DC for every phase
+        for (int tap = 0; tap < numTaps; ++tap)
+            row[tap] = (float) (row[tap] / sum);
+    }
+
+    auto numChunks = (numOutputFrames + chunkSize - 1) / chunkSize;
+
+    return SampleData::build(source.getName(), view.numChannels, numOutputFrames, targetRate, [&](float* const* channels) {
+        parallelFor(view.numChannels * numChunks, [&](int task) {
+            const auto* input = view.getChannel(task / numChunks);
+            auto* output = channels[task / numChunks];
+
+            auto start = (task % numChunks) * chunkSize;
+            auto end = juce::jmin(numOutputFrames, start + chunkSize);
+
+            for (int i = start; i < end; ++i) {
+                auto position = i * step;
+                auto index = (int) position;
+                auto phasePosition = (float) (position - index) * numPhases;
+                auto phase = juce::jmin(numPhases - 1, (int) phasePosition);
+                auto phaseAlpha = phasePosition - (float) phase;
+
+                const auto* row0 = table.data() + (size_t) phase * (size_t) numTaps;
+                const auto* row1 = row0 + numTaps;
+                auto first = index - (halfTaps - 1);
+
+                // the kernel is wider than the padding, anything past it counts as silence
+                auto tapBegin = juce::jmax(0, -SampleData::paddingFrames - first);
+                auto tapEnd = juce::jmin(numTaps, view.numFrames + SampleData::paddingFrames - first);
+
+                float sum0 = 0.0f, sum1 = 0.0f;
+
+                for (int tap = tapBegin; tap < tapEnd; ++tap) {
+                    sum0 += row0[tap] * input[first + tap];
+                    sum1 += row1[tap] * input[first + tap];
+                }
+
+                output[i] = sum0 + phaseAlpha * (sum1 - sum0);
+            }
+        });
+    });
+}
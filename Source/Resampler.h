@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    Resampler.h
+    Created: 25 Jan 2025 1:36:48pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleData.h"
+
+//==============================================================================
+/*
+    Converts a whole sample to another rate once, at load time, so the voices
+    don't have to do it on every note.
+
+    A Kaiser windowed sinc with zeroCrossings zero crossings on each side,
+    tabulated at numPhases fractional positions and interpolated between them.
+    Downsampling stretches the kernel so its cutoff sits below the new Nyquist.
+    That is far more than a voice could afford per note.
+*/
+struct Resampler
+{
+    static constexpr int zeroCrossings = 32;
+    static constexpr int numPhases = 1024;
+    static constexpr int chunkSize = 16384;
+
+    /** Runs task(0) to task(numTasks - 1), in any order and on any threads, and returns once they're all done. */
+    using ParallelFor = std::function<void(int numTasks, const std::function<void(int)>& task)>;
+
+    /** Returns a copy of the source at the target rate. Each channel is split into
+        chunks of chunkSize output frames, and the chunks are handed to parallelFor.
+    */
+    static SampleData::Ptr process(const SampleData& source, double targetRate, const ParallelFor& parallelFor);
+};
@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    SampleCache.cpp
+    Created: 18 Jan 2025 4:27:13pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "SampleCache.h"
+
+SampleCache::SampleCache()
+    : mDirectory(juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                     .getChildFile("YellowRose").getChildFile("SampleCache"))
+{
+    mDirectory.createDirectory();
+
+    // only the first time, when nothing's mapped by this process yet. The shared instance can
+    // go away and come back while the samples it mapped are still playing.
+    static std::atomic<bool> trimmed{ false };
+
+    if (!trimmed.exchange(true))
+        trim();
+}
+
+juce::File SampleCache::getFileFor(const juce::File& source, juce::uint64 contentHash, double resampledRate) const
+{
+    // an edit in the middle of a file that keeps its size doesn't change the content hash,
+    // it does change the modification time
+    auto key = contentHash;
+
+    for (auto value : { (juce::uint64) source.getFullPathName().hashCode64(), (juce::uint64) source.getSize(),
+                        (juce::uint64) source.getLastModificationTime().toMilliseconds() })
+        key = (key ^ value) * 0x100000001b3ull;
+
+    auto name = juce::String::toHexString((juce::int64) key).paddedLeft('0', 16);
+
+    if (resampledRate > 0.0)
+        name << "-" << juce::roundToInt(resampledRate);
+
+    return mDirectory.getChildFile(name + ".yrpcm");
+}
+
+SampleData::Ptr SampleCache::find(const juce::File& source, juce::uint64 contentHash, double resampledRate)
+{
+    if (contentHash == 0)
+        return nullptr;
+
+    auto file = getFileFor(source, contentHash, resampledRate);
+
+    if (!file.existsAsFile())
+        return nullptr;
+
+    auto data = SampleData::fromCacheFile(source.getFileNameWithoutExtension(), file);
+
+    // most file systems don't keep access times reliably, so trim() goes by this. A day is
+    // fine enough for that, and saves writing to the directory on every load.
+    auto now = juce::Time::getCurrentTime();
+
+    if (data != nullptr && file.getLastModificationTime() < now - juce::RelativeTime::hours(usedResolutionHours))
+        file.setLastModificationTime(now);
+
+    return data;
+}
+
+SampleData::Ptr SampleCache::add(const juce::File& source, juce::uint64 contentHash, SampleData::Ptr data, double resampledRate)
+{
+    if (contentHash == 0 || data == nullptr)
+        return data;
+
+    auto file = getFileFor(source, contentHash, resampledRate);
+
+    // written next to the target and moved into place, so nobody ever maps half a file
+    {
+        const juce::InterProcessLock::ScopedLockType sl(mDirectoryLock);
+        juce::TemporaryFile temp(file);
+
+        if (!data->writeCacheFile(temp.getFile()) || !temp.overwriteTargetFileWithTemporary())
+            return data;
+    }
+
+    if (auto mapped = SampleData::fromCacheFile(data->getName(), file))
+        return mapped;
+
+    return data;
+}
+
+void SampleCache::trim()
+{
+    const juce::InterProcessLock::ScopedLockType sl(mDirectoryLock);
+
+    auto files = mDirectory.findChildFiles(juce::File::findFiles, false, "*.yrpcm");
+
+    std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b) {
+        return a.getLastModificationTime() > b.getLastModificationTime();
+    });
+
+    juce::int64 total = 0;
+
+    for (auto& file : files) {
+        total += file.getSize();
+
+        // another process that still maps a file keeps its pages, the name just goes away.
+        // Where mapped files can't be deleted, they stay until a later start.
+        if (total > mMaxSizeInBytes)
+            file.deleteFile();
+    }
+}
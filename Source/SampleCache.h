@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    SampleCache.h
+    Created: 18 Jan 2025 4:27:13pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleData.h"
+
+//==============================================================================
+/*
+    Decoded samples kept on disk as raw float files, named by the ContentHash of
+    the file they came from together with its path, size and modification time.
+    The hash alone only covers the ends of the file. Loading one is a memory map
+    instead of a decode, and every instance that maps the same file shares its
+    pages in the OS page cache. Copies converted to another rate are cached under
+    the same key and that rate.
+
+    When the first cache in a process is created, the files that were used least
+    recently are deleted until the cache is within its size limit. That happens
+    under a lock shared by every process, and never while this process could have
+    any of them mapped. Share one through a juce::SharedResourcePointer; every
+    method can be called from any thread except the audio thread.
+*/
+class SampleCache
+{
+public:
+    static constexpr juce::int64 defaultMaxSizeInBytes = (juce::int64) 4 << 30;
+
+    // a file that's used again is only marked as used when it last was longer ago than this
+    static constexpr int usedResolutionHours = 24;
+
+    SampleCache();
+
+    /** Returns the mapped sample decoded from the source file, or null if it isn't cached. */
+    SampleData::Ptr find(const juce::File& source, juce::uint64 contentHash, double resampledRate = 0.0);
+
+    /** Writes the data decoded from the source file to the cache, and returns the
+        mapped copy, or the original data if it couldn't be written.
+    */
+    SampleData::Ptr add(const juce::File& source, juce::uint64 contentHash, SampleData::Ptr data, double resampledRate = 0.0);
+
+    /** Takes effect the next time a process starts using the cache. */
+    void setMaxSizeInBytes(juce::int64 maxSize) { mMaxSizeInBytes = maxSize; }
+
+    juce::File getDirectory() const { return mDirectory; }
+
+private:
+    juce::File getFileFor(const juce::File& source, juce::uint64 contentHash, double resampledRate) const;
+    void trim();
+
+    const juce::File mDirectory;
+    std::atomic<juce::int64> mMaxSizeInBytes{ defaultMaxSizeInBytes };
+
+    // held while files are written or trimmed, by every process that uses the cache
+    juce::InterProcessLock mDirectoryLock{ "YellowRoseSampleCache" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleCache)
+};
@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    SampleData.cpp
+    Created: 16 Nov 2024 2:48:10pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "SampleData.h"
+
+namespace
+{
+    // the header takes a page, so every channel after it starts page aligned
+    constexpr juce::int64 cacheHeaderSize = 4096;
+    constexpr juce::uint32 cacheMagic = 0x43505259; // "YRPC"
+    constexpr juce::uint32 cacheVersion = 1;
+
+    struct CacheHeader
+    {
+        juce::uint32 magic, version;
+        juce::uint32 numChannels, paddingFrames;
+        juce::int64 numFrames;
+        juce::int64 channelStride; // in floats, a multiple of 16 so every channel is 64 byte aligned
+        double sampleRate;
+    };
+
+    juce::int64 getChannelStride(int numFrames)
+    {
+        return ((juce::int64) numFrames + 2 * SampleData::paddingFrames + 15) / 16 * 16;
+    }
+}
+
+SampleData::SampleData(const juce::String& name, juce::AudioBuffer<float>&& buffer, double sampleRate, bool isFilling)
+    : mName(name), mBuffer(std::move(buffer)),
+      mNumChannels(mBuffer.getNumChannels()), mNumFrames(mBuffer.getNumSamples() - 2 * paddingFrames), mSampleRate(sampleRate),
+      mFramesReady(isFilling ? 0 : mNumFrames), mIsFilling(isFilling)
+{
+    jassert(mNumChannels == 1 || mNumChannels == 2);
+
+    for (int ch = 0; ch < mNumChannels; ++ch) {
+        mChannels[ch] = mBuffer.getReadPointer(ch);
+
+        if (isFilling)
+            mFillChannels[ch] = mBuffer.getWritePointer(ch);
+    }
+}
+
+SampleData::SampleData(const juce::String& name, std::unique_ptr<juce::MemoryMappedFile> mappedFile,
+                       const float* const* paddedChannels, int numChannels, int numFrames, double sampleRate)
+    : mName(name), mMappedFile(std::move(mappedFile)), mNumChannels(numChannels), mNumFrames(numFrames), mSampleRate(sampleRate),
+      mFramesReady(numFrames), mIsFilling(false)
+{
+    jassert(mNumChannels == 1 || mNumChannels == 2);
+
+    for (int ch = 0; ch < mNumChannels; ++ch)
+        mChannels[ch] = paddedChannels[ch];
+}
+
+juce::AudioBuffer<float> SampleData::createPaddedBuffer(int numChannels, int numFrames)
+{
+    juce::AudioBuffer<float> buffer(numChannels, numFrames + 2 * paddingFrames);
+    buffer.clear();
+    return buffer;
+}
+
+SampleData::Ptr SampleData::fromReader(const juce::String& name, juce::AudioFormatReader& reader, juce::int64 maxFrames)
+{
+    auto numFrames = (int) juce::jmin(reader.lengthInSamples, maxFrames);
+    auto numChannels = juce::jlimit(1, 2, (int) reader.numChannels);
+
+    auto buffer = createPaddedBuffer(numChannels, numFrames);
+    reader.read(&buffer, paddingFrames, numFrames, 0, true, numChannels > 1);
+
+    return new SampleData(name, std::move(buffer), reader.sampleRate);
+}
+
+SampleData::Ptr SampleData::fromBuffer(const juce::String& name, const juce::AudioBuffer<float>& source, double sampleRate)
+{
+    auto numFrames = source.getNumSamples();
+    auto numChannels = juce::jlimit(1, 2, source.getNumChannels());
+
+    auto buffer = createPaddedBuffer(numChannels, numFrames);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        buffer.copyFrom(ch, paddingFrames, source, ch, 0, numFrames);
+
+    return new SampleData(name, std::move(buffer), sampleRate);
+}
+
+SampleData::Ptr SampleData::build(const juce::String& name, int numChannels, int numFrames, double sampleRate,
+                                  const std::function<void(float* const* channels)>& fill)
+{
+    auto buffer = createPaddedBuffer(numChannels, numFrames);
+    float* channels[2] = { buffer.getWritePointer(0, paddingFrames), numChannels > 1 ? buffer.getWritePointer(1, paddingFrames) : nullptr };
+
+    fill(channels);
+
+    return new SampleData(name, std::move(buffer), sampleRate);
+}
+
+SampleData::Ptr SampleData::createForFilling(const juce::String& name, int numChannels, int numFrames, double sampleRate)
+{
+    return new SampleData(name, createPaddedBuffer(juce::jlimit(1, 2, numChannels), numFrames), sampleRate, true);
+}
+
+void SampleData::fillFrom(juce::AudioFormatReader& reader, int startFrame, int numFrames)
+{
+    jassert(mIsFilling);
+    jassert(startFrame >= mFramesReady.load(std::memory_order_relaxed));
+
+    numFrames = juce::jmin(numFrames, mNumFrames - startFrame);
+
+    if (numFrames <= 0)
+        return;
+
+    // a buffer of our own over the range, so threads filling other ranges never touch mBuffer itself
+    float* channels[2] = { mFillChannels[0] + paddingFrames + startFrame,
+                           mNumChannels > 1 ? mFillChannels[1] + paddingFrames + startFrame : nullptr };
+
+    juce::AudioBuffer<float> range(channels, mNumChannels, numFrames);
+    reader.read(&range, 0, numFrames, startFrame, true, mNumChannels > 1);
+}
+
+void SampleData::setNumFramesReady(int numFrames) noexcept
+{
+    jassert(mIsFilling);
+    jassert(numFrames >= mFramesReady.load(std::memory_order_relaxed) && numFrames <= mNumFrames);
+
+    // readers acquire this, the caller makes sure the frames written on other threads happened before it
+    mFramesReady.store(numFrames, std::memory_order_release);
+}
+
+SampleData::Ptr SampleData::fromCacheFile(const juce::String& name, const juce::File& file)
+{
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+
+    if (mapped->getData() == nullptr || (juce::int64) mapped->getSize() < cacheHeaderSize)
+        return nullptr;
+
+    CacheHeader header;
+    std::memcpy(&header, mapped->getData(), sizeof(header));
+
+    if (header.magic != cacheMagic || header.version != cacheVersion
+        || header.numChannels < 1 || header.numChannels > 2
+        || header.paddingFrames != (juce::uint32) paddingFrames
+        || header.numFrames < 0 || header.numFrames > std::numeric_limits<int>::max() - 2 * paddingFrames
+        || header.channelStride != getChannelStride((int) header.numFrames)
+        || (juce::int64) mapped->getSize() < cacheHeaderSize + (juce::int64) header.numChannels * header.channelStride * (juce::int64) sizeof(float))
+        return nullptr;
+
+    auto* base = reinterpret_cast<const float*>(static_cast<const char*>(mapped->getData()) + cacheHeaderSize);
+    const float* channels[2] = { base, base + header.channelStride };
+
+    // pull every page in now, on the loader thread
+    volatile float sink = 0.0f;
+    constexpr int floatsPerPage = 4096 / sizeof(float);
+
+    for (juce::uint32 ch = 0; ch < header.numChannels; ++ch)
+        for (juce::int64 i = 0; i < header.channelStride; i += floatsPerPage)
+            sink = sink + channels[ch][i];
+
+    return new SampleData(name, std::move(mapped), channels, (int) header.numChannels, (int) header.numFrames, header.sampleRate);
+}
+
+bool SampleData::writeCacheFile(const juce::File& file) const
+{
+    juce::FileOutputStream stream(file);
+
+    if (!stream.openedOk())
+        return false;
+
+    stream.setPosition(0);
+    stream.truncate();
+
+    CacheHeader header{ cacheMagic, cacheVersion, (juce::uint32) mNumChannels, (juce::uint32) paddingFrames,
+                        mNumFrames, getChannelStride(mNumFrames), mSampleRate };
+
+    juce::HeapBlock<char> headerBlock((size_t) cacheHeaderSize, true);
+    std::memcpy(headerBlock, &header, sizeof(header));
+    stream.write(headerBlock, (size_t) cacheHeaderSize);
+
+    auto numPaddedFrames = (size_t) mNumFrames + 2 * paddingFrames;
+    auto numZeros = (size_t) header.channelStride - numPaddedFrames;
+    const float zeros[16]{};
+
+    for (int ch = 0; ch < mNumChannels; ++ch) {
+        stream.write(mChannels[ch], numPaddedFrames * sizeof(float));
+        stream.write(zeros, numZeros * sizeof(float));
+    }
+
+    stream.flush();
+    return stream.getStatus().wasOk();
+}
+
+SampleView SampleData::getView() const noexcept
+{
+    SampleView view;
+    view.numChannels = mNumChannels;
+    view.numFrames = mNumFrames;
+    view.sampleRate = mSampleRate;
+    view.framesReady = mIsFilling ? &mFramesReady : nullptr;
+
+    for (int ch = 0; ch < view.numChannels; ++ch)
+        view.channels[ch] = mChannels[ch] + paddingFrames;
+
+    return view;
+}
+
+size_t SampleData::getSizeInBytes() const noexcept
+{
+    return (size_t) mNumChannels * ((size_t) mNumFrames + 2 * paddingFrames) * sizeof(float);
+}
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    SampleData.h
+    Created: 16 Nov 2024 2:48:10pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    A non-owning view of decoded audio. Cheap to pass around by value; it stays
+    valid for as long as the SampleData it came from is referenced.
+*/
+struct SampleView
+{
+    // each channel has SampleData::paddingFrames of silence readable on either side
+    const float* channels[2]{ nullptr, nullptr };
+    int numChannels{ 0 };
+    int numFrames{ 0 };
+    double sampleRate{ 0.0 };
+
+    // only set for data that's still being filled in, see SampleData::createForFilling()
+    const std::atomic<int>* framesReady{ nullptr };
+
+    bool isEmpty() const noexcept { return numFrames <= 0; }
+
+    /** How many frames from the start can be read yet. All of them, unless the data
+        is still being decoded; the frames past this point read as silence until then.
+    */
+    int getNumFramesReady() const noexcept { return framesReady != nullptr ? framesReady->load(std::memory_order_acquire) : numFrames; }
+
+    /** Never returns null, a mono view returns the left channel for both sides. */
+    const float* getChannel(int channel) const noexcept { return channels[juce::jmin(channel, numChannels - 1)]; }
+};
+
+//==============================================================================
+/*
+    Decoded audio that never changes after it has been built. Voices, the thumbnail
+    and anything else that needs the samples share one of these through a
+    reference-counted pointer and read it through views, nobody keeps a copy.
+
+    The frames are surrounded by silence, so interpolators can read a few frames
+    past either end without checking.
+
+    The channels either live in memory or in a memory-mapped cache file written
+    by writeCacheFile(), which every instance in every process maps read-only, so
+    they all share the same pages.
+
+    The one exception to never changing is data made by createForFilling(): it
+    starts out silent and gets decoded into, by one thread or by several working on
+    ranges of their own, while the filling side publishes how many frames from the
+    start are done. Readers only read the frames that are ready.
+*/
+class SampleData  : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<SampleData>;
+
+    static constexpr int paddingFrames = 16;
+
+    /** Decodes up to maxFrames frames from the reader, keeping at most two channels. */
+    static Ptr fromReader(const juce::String& name, juce::AudioFormatReader& reader,
+                          juce::int64 maxFrames = std::numeric_limits<int>::max() - 2 * paddingFrames);
+
+    /** Copies the first one or two channels of a buffer. */
+    static Ptr fromBuffer(const juce::String& name, const juce::AudioBuffer<float>& source, double sampleRate);
+
+    /** Allocates the padded channels and has fill write the frames in place. */
+    static Ptr build(const juce::String& name, int numChannels, int numFrames, double sampleRate,
+                     const std::function<void(float* const* channels)>& fill);
+
+    /** Silent data of the full length, for fillFrom() to decode into while it's
+        already being played. Keeps at most two channels.
+    */
+    static Ptr createForFilling(const juce::String& name, int numChannels, int numFrames, double sampleRate);
+
+    /** Decodes numFrames frames from startFrame on, which mustn't be ready yet. Only
+        for data from createForFilling(). Several threads can fill ranges that don't
+        overlap at the same time, each with a reader of its own.
+    */
+    void fillFrom(juce::AudioFormatReader& reader, int startFrame, int numFrames);
+
+    /** Makes the first numFrames frames readable, once every one of them is filled. */
+    void setNumFramesReady(int numFrames) noexcept;
+
+    /** Gives up on decoding the rest, which is left silent. Voices that are waiting
+        for more frames play the silence and end as usual.
+    */
+    void finishFilling() noexcept { mFramesReady.store(mNumFrames, std::memory_order_release); }
+
+    /** Maps a file written by writeCacheFile(), or returns null if it isn't one.
+        Every page is touched once here, so the audio thread doesn't take the
+        first faults.
+    */
+    static Ptr fromCacheFile(const juce::String& name, const juce::File& file);
+
+    /** Writes the padded channels in the layout fromCacheFile() maps. */
+    bool writeCacheFile(const juce::File& file) const;
+
+    const juce::String& getName() const noexcept { return mName; }
+    double getSampleRate() const noexcept { return mSampleRate; }
+    int getNumChannels() const noexcept { return mNumChannels; }
+    int getNumFrames() const noexcept { return mNumFrames; }
+    bool isMemoryMapped() const noexcept { return mMappedFile != nullptr; }
+    bool isComplete() const noexcept { return mFramesReady.load(std::memory_order_acquire) == mNumFrames; }
+
+    SampleView getView() const noexcept;
+
+    /** Size of the decoded audio, for bookkeeping. Mapped data counts too,
+        although it lives in the page cache rather than on the heap.
+    */
+    size_t getSizeInBytes() const noexcept;
+
+private:
+    /** Takes over a buffer that already has the padding on both sides. */
+    SampleData(const juce::String& name, juce::AudioBuffer<float>&& paddedBuffer, double sampleRate, bool isFilling = false);
+
+    /** Channels that start with their padding, inside the mapped file. */
+    SampleData(const juce::String& name, std::unique_ptr<juce::MemoryMappedFile> mappedFile,
+               const float* const* paddedChannels, int numChannels, int numFrames, double sampleRate);
+
+    static juce::AudioBuffer<float> createPaddedBuffer(int numChannels, int numFrames);
+
+    const juce::String mName;
+    juce::AudioBuffer<float> mBuffer; // empty when mapped, only fillFrom() writes to it
+    const std::unique_ptr<juce::MemoryMappedFile> mMappedFile;
+    const float* mChannels[2]{ nullptr, nullptr }; // each starts with its padding
+
+    // mBuffer's write pointers, taken once up front for data that's filled in. Taking them
+    // in fillFrom() would have every filling thread write to mBuffer's clear flag.
+    float* mFillChannels[2]{ nullptr, nullptr };
+    const int mNumChannels;
+    const int mNumFrames;
+    const double mSampleRate;
+
+    std::atomic<int> mFramesReady;
+    const bool mIsFilling;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleData)
+};
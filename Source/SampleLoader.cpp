@@ -0,0 +1,533 @@
+/*
+  ==============================================================================
+
+    SampleLoader.cpp
+    Created: 2 Nov 2024 7:12:54pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "SampleLoader.h"
+#include "StreamingVoice.h"
+#include "SampleVoice.h"
+#include "SfzFile.h"
+#include "ContentHash.h"
+#include "Resampler.h"
+
+namespace
+{
+    int getNumFramesToDecode(const juce::AudioFormatReader& reader)
+    {
+        return (int) juce::jmin(reader.lengthInSamples, (juce::int64) std::numeric_limits<int>::max() - 2 * SampleData::paddingFrames);
+    }
+
+    // JUCE's MP3 reader restarts its decoder a frame before the one it seeks to, and the
+    // bit reservoir can reach back further than that, so a chunk could start off slightly
+    // different from a straight decode. WAV, AIFF, FLAC and Ogg land on the exact frame.
+    bool seeksToExactFrames(const juce::AudioFormatReader& reader)
+    {
+        return !reader.getFormatName().containsIgnoreCase("MP3");
+    }
+}
+
+SampleLoader::SampleLoader(DiskStreamer& streamer) : juce::Thread("YellowRose sample loader"), mStreamer(streamer)
+{
+    mFormatManager.registerBasicFormats();
+    startThread(juce::Thread::Priority::background);
+}
+
+SampleLoader::~SampleLoader()
+{
+    shutdown();
+}
+
+void SampleLoader::loadFile(const juce::File& file)
+{
+    {
+        const NonRealtimeLock::ScopedLockType sl(mRequestLock);
+        mPendingFile = file;
+        mHasPendingFile = true;
+    }
+
+    mWake.signal();
+}
+
+void SampleLoader::setLoopSettings(const LoopSettings& settings) noexcept
+{
+    mLoopMode = (int) settings.mode;
+    mLoopStart = settings.start;
+    mLoopEnd = settings.end;
+    mLoopCrossfadeMs = settings.crossfadeMs;
+
+    // this may be the audio thread, the semaphore doesn't lock
+    mLoopChanged = true;
+    mWake.signal();
+}
+
+LoopSettings SampleLoader::getLoopSettings() const noexcept
+{
+    return { (LoopMode) mLoopMode.load(), mLoopStart.load(), mLoopEnd.load(), mLoopCrossfadeMs.load() };
+}
+
+void SampleLoader::shutdown()
+{
+    signalThreadShouldExit();
+    mWake.signal();
+    stopThread(4000);
+}
+
+bool SampleLoader::hasPendingRequest() const
+{
+    const NonRealtimeLock::ScopedLockType sl(mRequestLock);
+    return mHasPendingFile;
+}
+
+bool SampleLoader::shouldAbort() const
+{
+    return threadShouldExit() || hasPendingRequest();
+}
+
+void SampleLoader::run()
+{
+    while (!threadShouldExit()) {
+        juce::File file;
+
+        {
+            const NonRealtimeLock::ScopedLockType sl(mRequestLock);
+
+            if (mHasPendingFile) {
+                file = mPendingFile;
+                mHasPendingFile = false;
+            }
+        }
+
+        if (file == juce::File()) {
+            if (mLoopChanged.exchange(false))
+                reloop();
+            else
+                mWake.wait(-1);
+
+            continue;
+        }
+
+        juce::uint64 hash = 0;
+
+        if (auto sound = createSound(file, hash)) {
+            // the receiver compares the hash with the one it asked for, see YellowRoseAudioProcessor::hasSampleChanged()
+            handOver(sound, { file, hash });
+        }
+
+        mStore->purgeUnused();
+    }
+}
+
+void SampleLoader::reloop()
+{
+    // a drag changes the settings many times a second, the loops are only rebuilt once they
+    // settle. Automation may never settle, so it's held off for maxLoopDelayMs at most.
+    auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) maxLoopDelayMs;
+
+    while (!shouldAbort()) {
+        auto remaining = (int) (deadline - juce::Time::getMillisecondCounter());
+
+        if (remaining <= 0 || !mWake.wait(juce::jmin(loopSettleMs, remaining)))
+            break;
+    }
+
+    // a new file gets the latest settings when it's handed over
+    if (shouldAbort())
+        return;
+
+    mLoopChanged = false;
+    auto settings = getLoopSettings();
+
+    if (mLastSound == nullptr || settings == mLastLoop)
+        return;
+
+    auto looped = withLoop(mLastSound, settings);
+    mLastLoop = settings;
+
+    if (looped != mLastSound && onSoundLoaded != nullptr) {
+        mLastSound = looped;
+        onSoundLoaded(looped, mLastReference);
+    }
+}
+
+void SampleLoader::handOver(juce::SynthesiserSound::Ptr sound, const SampleReference& reference)
+{
+    mLastLoop = getLoopSettings();
+    sound = withLoop(sound, mLastLoop);
+    mLastSound = sound;
+    mLastReference = reference;
+
+    if (onSoundLoaded != nullptr)
+        onSoundLoaded(sound, reference);
+}
+
+juce::SynthesiserSound::Ptr SampleLoader::createSound(const juce::File& file, juce::uint64& hash)
+{
+    // an instrument counts as changed when its .sfz does, not when one of its samples does
+    if (file.hasFileExtension("sfz")) {
+        hash = ContentHash::ofFile(file);
+        return createInstrument(file);
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> reader(mFormatManager.createReaderFor(file));
+
+    if (reader == nullptr)
+        return nullptr;
+
+    juce::BigInteger range;
+    range.setRange(0, 127, true);
+
+    if (mStreamingEnabled && reader->lengthInSamples > (juce::int64) (reader->sampleRate * streamingThresholdSeconds)) {
+        auto peaks = getPeaks(file, *reader, nullptr, false);
+
+        // gave up half way through the file, there's a newer request or we're shutting down
+        if (peaks == nullptr)
+            return nullptr;
+
+        hash = ContentHash::ofFile(file);
+        return new StreamingSound(file.getFileNameWithoutExtension(), file, *reader, range, 60, mStreamer, peaks);
+    }
+
+    auto data = findSampleData(file, reader->sampleRate, hash);
+
+    // nothing to share or map, so it's decoded while it's already playing
+    if (data == nullptr && mProgressiveLoading && reader->lengthInSamples > 2 * progressiveChunkFrames
+        && mStore->find(file) == nullptr)
+        return loadProgressively(file, *reader, hash, range);
+
+    if (data == nullptr)
+        data = toStoredRate(file, getDecodedData(file, *reader, hash), hash);
+
+    if (data == nullptr)
+        return nullptr;
+
+    return new SampleSound(data, getPeaks(file, *reader, data.get(), isResampled(*data, *reader)), range, 60);
+}
+
+juce::SynthesiserSound::Ptr SampleLoader::loadProgressively(const juce::File& file, juce::AudioFormatReader& reader,
+                                                            juce::uint64 hash, const juce::BigInteger& midiNotes)
+{
+    auto numFrames = getNumFramesToDecode(reader);
+    auto data = SampleData::createForFilling(file.getFileNameWithoutExtension(), (int) reader.numChannels, numFrames, reader.sampleRate);
+    auto firstChunk = juce::jmin(numFrames, progressiveChunkFrames);
+
+    data->fillFrom(reader, 0, firstChunk);
+    data->setNumFramesReady(firstChunk);
+
+    // the peaks of the rest read as silence, the thumbnail fills them in as it goes
+    PeakPyramid::Builder peaks(data->getNumChannels());
+    peaks.addFrames(data->getView().channels, firstChunk);
+    handOver(new SampleSound(data, peaks.snapshot(numFrames), midiNotes, 60), { file, hash });
+
+    if (!decodeInto(*data, file, reader)) {
+        // notes that are still playing it run into silence and end
+        data->finishFilling();
+        return nullptr;
+    }
+
+    // from here on it's a decoded copy like any other, shared, cached and at the target rate
+    auto decoded = toStoredRate(file, mStore->add(file, hash, addToCache(file, hash, data, 0.0)), hash);
+    return new SampleSound(decoded, getPeaks(file, reader, decoded.get(), isResampled(*decoded, reader)), midiNotes, 60);
+}
+
+juce::SynthesiserSound::Ptr SampleLoader::createInstrument(const juce::File& sfzFile)
+{
+    auto regions = SfzFile::read(sfzFile);
+
+    // instruments usually map the same file from several regions, each is decoded once
+    juce::Array<juce::File> files;
+
+    for (auto& region : regions)
+        files.addIfNotAlreadyThere(region.sample);
+
+    std::vector<SampleData::Ptr> data((size_t) files.size());
+    std::vector<PeakPyramid::Ptr> peaks((size_t) files.size());
+
+    runInParallel(files.size(), [&](int i) {
+        if (shouldAbort())
+            return;
+
+        std::unique_ptr<juce::AudioFormatReader> reader(mFormatManager.createReaderFor(files[i]));
+
+        if (reader == nullptr)
+            return;
+
+        if (auto sampleData = getSampleData(files[i], *reader)) {
+            peaks[(size_t) i] = getPeaks(files[i], *reader, sampleData.get(), isResampled(*sampleData, *reader));
+            data[(size_t) i] = sampleData;
+        }
+    });
+
+    if (shouldAbort())
+        return nullptr;
+
+    std::vector<KeyZone> zones;
+    zones.reserve(regions.size());
+
+    for (auto& region : regions) {
+        auto index = (size_t) files.indexOf(region.sample);
+
+        // files that don't exist or can't be decoded leave a gap in the map
+        if (data[index] == nullptr)
+            continue;
+
+        KeyZone zone;
+        zone.data = data[index];
+        zone.peaks = peaks[index];
+        zone.rootNote = region.rootNote;
+        zone.lowNote = region.lowNote;
+        zone.highNote = region.highNote;
+        zone.lowVelocity = region.lowVelocity;
+        zone.highVelocity = region.highVelocity;
+        zone.sequencePosition = region.sequencePosition;
+        zone.gain = juce::Decibels::decibelsToGain(region.volumeDecibels);
+        zone.tuneSemitones = region.transpose + region.tuneCents / 100.0;
+        zone.outputBus = region.output;
+        zones.push_back(zone);
+    }
+
+    if (zones.empty())
+        return nullptr;
+
+    return new SampleSound(sfzFile.getFileNameWithoutExtension(), new Keymap(std::move(zones)));
+}
+
+juce::SynthesiserSound::Ptr SampleLoader::withLoop(juce::SynthesiserSound::Ptr sound, const LoopSettings& settings)
+{
+    // streamed sounds keep only their head in memory, there's nothing to loop
+    if (auto* sampleSound = dynamic_cast<SampleSound*>(sound.get()))
+        return sampleSound->withLoop(settings).get();
+
+    return sound;
+}
+
+void SampleLoader::runInParallel(int numTasks, const std::function<void(int)>& task)
+{
+    // a task that runs in parallel itself would reset the jobs of the call it's part of
+    if (juce::Thread::getCurrentThread() != static_cast<juce::Thread*>(this) || mRunningInParallel) {
+        for (int i = 0; i < numTasks; ++i)
+            task(i);
+
+        return;
+    }
+
+    std::atomic<int> nextTask{ 0 };
+
+    auto runTasks = [&] {
+        for (int i = nextTask++; i < numTasks; i = nextTask++)
+            task(i);
+    };
+
+    auto numJobs = juce::jmin(mDecodePool->getNumThreads(), numTasks - 1);
+    mNumDecodeJobs = juce::jmax(0, numJobs);
+    mDecodeFinished.reset();
+    const juce::ScopedValueSetter<bool> running(mRunningInParallel, true);
+
+    for (int i = 0; i < numJobs; ++i) {
+        mDecodePool->addJob([this, &runTasks] {
+            runTasks();
+
+            if (--mNumDecodeJobs == 0)
+                mDecodeFinished.signal();
+        });
+    }
+
+    runTasks();
+
+    if (numJobs > 0)
+        mDecodeFinished.wait(-1);
+}
+
+SampleData::Ptr SampleLoader::getSampleData(const juce::File& file, juce::AudioFormatReader& reader)
+{
+    juce::uint64 hash = 0;
+
+    if (auto data = findSampleData(file, reader.sampleRate, hash))
+        return data;
+
+    return toStoredRate(file, getDecodedData(file, reader, hash), hash);
+}
+
+double SampleLoader::getStoredRate(double sourceRate) const
+{
+    auto targetRate = mTargetSampleRate.load();
+    return targetRate > 0.0 && std::abs(sourceRate - targetRate) > 0.5 ? targetRate : 0.0;
+}
+
+SampleData::Ptr SampleLoader::findSampleData(const juce::File& file, double sourceRate, juce::uint64& hash)
+{
+    auto storedRate = getStoredRate(sourceRate);
+
+    // whoever put the file in the store hashed it already, only a new file is read for it
+    hash = mStore->findHash(file);
+
+    if (hash == 0)
+        hash = ContentHash::ofFile(file);
+
+    if (auto data = mStore->find(file, storedRate))
+        return data;
+
+    if (auto cached = findCached(file, hash, storedRate))
+        return mStore->add(file, hash, cached, storedRate);
+
+    return nullptr;
+}
+
+SampleData::Ptr SampleLoader::toStoredRate(const juce::File& file, SampleData::Ptr decoded, juce::uint64 hash)
+{
+    if (decoded == nullptr)
+        return nullptr;
+
+    auto targetRate = getStoredRate(decoded->getSampleRate());
+
+    if (targetRate == 0.0)
+        return decoded;
+
+    auto resampled = Resampler::process(*decoded, targetRate, [this](int numTasks, const std::function<void(int)>& task) {
+        runInParallel(numTasks, task);
+    });
+
+    return mStore->add(file, hash, addToCache(file, hash, resampled, targetRate), targetRate);
+}
+
+SampleData::Ptr SampleLoader::getDecodedData(const juce::File& file, juce::AudioFormatReader& reader, juce::uint64 hash)
+{
+    if (auto data = mStore->find(file))
+        return data;
+
+    auto name = file.getFileNameWithoutExtension();
+
+    if (auto cached = findCached(file, hash, 0.0))
+        return mStore->add(file, hash, cached);
+
+    auto data = SampleData::createForFilling(name, (int) reader.numChannels, getNumFramesToDecode(reader), reader.sampleRate);
+
+    if (!decodeInto(*data, file, reader))
+        return nullptr;
+
+    // once it's written the store keeps the mapped copy, and the decoded one is freed
+    return mStore->add(file, hash, addToCache(file, hash, data, 0.0));
+}
+
+bool SampleLoader::decodeInto(SampleData& data, const juce::File& file, juce::AudioFormatReader& reader)
+{
+    auto* loaderThread = static_cast<juce::Thread*>(this);
+    auto startFrame = data.getView().getNumFramesReady();
+    auto numFrames = data.getNumFrames();
+    auto numChunks = (int) (((juce::int64) numFrames - startFrame + parallelDecodeChunkFrames - 1) / parallelDecodeChunkFrames);
+
+    // runInParallel() only spreads work from the loader thread outside of another parallel
+    // run, anywhere else this would just open a reader per chunk to decode them in turn
+    if (mParallelDecoding && numChunks > 1 && seeksToExactFrames(reader)
+        && juce::Thread::getCurrentThread() == loaderThread && !mRunningInParallel) {
+        NonRealtimeLock publishLock;
+        std::vector<bool> chunkDone((size_t) numChunks, false);
+        int numChunksReady = 0;
+        std::atomic<int> nextChunk{ 0 };
+        std::atomic<bool> readerFailed{ false };
+
+        // a task per thread rather than per chunk, so each opens one reader and takes chunks
+        // with it until there are none left
+        auto numThreads = juce::jmin(numChunks, mDecodePool->getNumThreads() + 1);
+
+        runInParallel(numThreads, [&](int) {
+            std::unique_ptr<juce::AudioFormatReader> ownReader;
+            juce::AudioFormatReader* chunkReader = nullptr;
+
+            for (int chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++) {
+                if (readerFailed || shouldAbort())
+                    return;
+
+                // opened for the first chunk the thread takes. The loader's reader is only
+                // ever used from the loader thread.
+                if (chunkReader == nullptr) {
+                    if (juce::Thread::getCurrentThread() == loaderThread) {
+                        chunkReader = &reader;
+                    }
+                    else {
+                        ownReader.reset(mFormatManager.createReaderFor(file));
+                        chunkReader = ownReader.get();
+                    }
+
+                    if (chunkReader == nullptr) {
+                        readerFailed = true;
+                        return;
+                    }
+                }
+
+                auto start = startFrame + chunk * parallelDecodeChunkFrames;
+                data.fillFrom(*chunkReader, start, juce::jmin(parallelDecodeChunkFrames, numFrames - start));
+
+                // chunks finish out of order, the frames only become readable once every chunk before them is done
+                const NonRealtimeLock::ScopedLockType sl(publishLock);
+                chunkDone[(size_t) chunk] = true;
+
+                while (numChunksReady < numChunks && chunkDone[(size_t) numChunksReady])
+                    ++numChunksReady;
+
+                data.setNumFramesReady((int) juce::jmin((juce::int64) numFrames,
+                                                        startFrame + (juce::int64) numChunksReady * parallelDecodeChunkFrames));
+            }
+        });
+
+        // a file that couldn't be opened again, the loader's reader picks up after the chunks that are in
+        if (!readerFailed)
+            return !shouldAbort();
+    }
+
+    for (;;) {
+        auto start = data.getView().getNumFramesReady();
+
+        if (start >= numFrames)
+            return true;
+
+        if (shouldAbort())
+            return false;
+
+        auto length = juce::jmin(progressiveChunkFrames, numFrames - start);
+        data.fillFrom(reader, start, length);
+        data.setNumFramesReady(start + length);
+    }
+}
+
+SampleData::Ptr SampleLoader::findCached(const juce::File& file, juce::uint64 hash, double resampledRate)
+{
+    return mUsesSampleCache ? mCache->find(file, hash, resampledRate) : nullptr;
+}
+
+SampleData::Ptr SampleLoader::addToCache(const juce::File& file, juce::uint64 hash, SampleData::Ptr data, double resampledRate)
+{
+    return mUsesSampleCache ? mCache->add(file, hash, data, resampledRate) : data;
+}
+
+bool SampleLoader::isResampled(const SampleData& data, const juce::AudioFormatReader& reader)
+{
+    return std::abs(data.getSampleRate() - reader.sampleRate) > 0.5;
+}
+
+PeakPyramid::Ptr SampleLoader::getPeaks(const juce::File& file, juce::AudioFormatReader& reader, const SampleData* data, bool resampled)
+{
+    // the peak file describes the file as it is, a converted copy gets its own pyramid
+    jassert(data != nullptr || !resampled);
+
+    if (resampled)
+        return PeakPyramid::build(data->getView());
+
+    auto peakFile = PeakPyramid::getPeakFileFor(file);
+
+    if (auto peaks = PeakPyramid::loadFrom(peakFile, file, reader.lengthInSamples))
+        return peaks;
+
+    // decoded samples are summarised from memory, anything else needs a pass over the file
+    auto peaks = data != nullptr ? PeakPyramid::build(data->getView())
+                                 : PeakPyramid::build(reader, [this] { return shouldAbort(); });
+
+    if (peaks != nullptr && mSavesPeakFiles)
+        peaks->saveTo(peakFile);
+
+    return peaks;
+}
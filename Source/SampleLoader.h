@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    SampleLoader.h
+    Created: 2 Nov 2024 7:12:54pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DiskStreamer.h"
+#include "SampleStore.h"
+#include "SampleCache.h"
+#include "PeakPyramid.h"
+#include "SampleLoop.h"
+#include "RealtimeSemaphore.h"
+
+//==============================================================================
+/*
+    Decodes samples on a background thread and hands back a fully built sound,
+    so neither the message thread nor the audio thread ever touches the disk.
+    Only the most recent request is kept; older pending requests are dropped.
+
+    Every sound comes with a peak pyramid for the thumbnail, read from its peak
+    file when there is an up to date one.
+
+    Decoded files go through the process-wide SampleStore, so a file that another
+    sound or plugin instance already holds is not decoded a second time. Below
+    that sits the on-disk SampleCache: a file that was ever decoded before is
+    memory-mapped from there instead of decoded again.
+
+    Files longer than the streaming threshold are not decoded into memory at all,
+    they become StreamingSounds that only preload their head. Offline renders turn
+    streaming off, they'd run ahead of the disk thread.
+
+    SFZ files become one SampleSound with a zone per region. Their samples are
+    decoded in parallel on a thread pool shared by every loader in the process,
+    with the loader thread joining in.
+
+    With a target rate set, decoded samples at any other rate are converted to it
+    by the Resampler before they're used, so a note on its root key plays the
+    frames as they are. The converted copies are stored and cached as well.
+
+    With progressive loading on, a file that has to be decoded is handed back as
+    soon as its first chunk is, with the rest still silent. The loader decodes
+    the rest into the same SampleData while it plays, then hands the sound back
+    again, finished, cached and converted. Offline renders turn this off too.
+
+    Long files are decoded in chunks of parallelDecodeChunkFrames on the decode
+    pool, each pool thread opening one reader and seeking it from chunk to chunk,
+    straight into the one SampleData. The frames are published as the chunks before them
+    complete, so a progressive load still fills in from the start. Formats whose
+    readers can't seek to an exact frame are decoded front to back.
+
+    Sounds in memory are looped as the loop settings say. When the settings change
+    the last sound is handed back again with new loops, sharing its samples.
+    Streamed sounds don't loop.
+*/
+class SampleLoader  : private juce::Thread
+{
+public:
+    static constexpr double streamingThresholdSeconds = 30.0;
+
+    // what a progressive load decodes before the sound is handed back, and at a time after that
+    static constexpr int progressiveChunkFrames = 1 << 15;
+
+    // what one pool thread decodes at a time, files shorter than two of these are decoded in one go
+    static constexpr int parallelDecodeChunkFrames = 1 << 16;
+
+    // how long the loop settings have to stay put before the loops are rebuilt, and the
+    // longest a steady stream of changes holds that off
+    static constexpr int loopSettleMs = 100;
+    static constexpr int maxLoopDelayMs = 500;
+
+    /** The file a sound was loaded from and its ContentHash. */
+    struct SampleReference
+    {
+        juce::File file;
+        juce::uint64 hash{ 0 };
+    };
+
+    SampleLoader(DiskStreamer& streamer);
+    ~SampleLoader() override;
+
+    /** Queues the file to be loaded. onSoundLoaded gets the hash of what was actually
+        read, so the caller can tell whether the file changed since it last saw it.
+    */
+    void loadFile(const juce::File& file);
+
+    /** Stops the loader thread. No more callbacks are made after this returns. */
+    void shutdown();
+
+    /** Whether peak pyramids are written to disk for the next load. */
+    void setSavesPeakFiles(bool shouldSave) { mSavesPeakFiles = shouldSave; }
+
+    /** The rate decoded samples are converted to from the next load on, or 0 to keep their own. */
+    void setTargetSampleRate(double sampleRate) { mTargetSampleRate = sampleRate; }
+
+    /** Whether long files stream from disk from the next load on, or are decoded whole. */
+    void setStreamingEnabled(bool shouldStream) { mStreamingEnabled = shouldStream; }
+
+    /** Whether files that have to be decoded are playable before they're done, from the next load on. */
+    void setProgressiveLoading(bool shouldLoadProgressively) { mProgressiveLoading = shouldLoadProgressively; }
+
+    /** Whether long files are decoded on the decode pool in chunks, from the next load on. */
+    void setParallelDecoding(bool shouldDecodeInParallel) { mParallelDecoding = shouldDecodeInParallel; }
+
+    /** Whether the on-disk SampleCache is read and written, from the next load on. */
+    void setUsesSampleCache(bool shouldUse) { mUsesSampleCache = shouldUse; }
+
+    /** Takes effect on the current sound once the settings have stayed put for
+        loopSettleMs, or after maxLoopDelayMs. Only stores the settings and wakes the
+        loader without locking, so it's safe from any thread, the audio thread included.
+    */
+    void setLoopSettings(const LoopSettings& settings) noexcept;
+    LoopSettings getLoopSettings() const noexcept;
+
+    /** Called on the loader thread once a sound has been built. A progressive load
+        calls it twice: with the first chunk decoded, and once it's complete.
+    */
+    std::function<void(juce::SynthesiserSound::Ptr, const SampleReference&)> onSoundLoaded;
+
+private:
+    void run() override;
+    /** Sets hash to the content hash of the file the sound was made from. */
+    juce::SynthesiserSound::Ptr createSound(const juce::File& file, juce::uint64& hash);
+    juce::SynthesiserSound::Ptr createInstrument(const juce::File& sfzFile);
+    juce::SynthesiserSound::Ptr loadProgressively(const juce::File& file, juce::AudioFormatReader& reader,
+                                                   juce::uint64 hash, const juce::BigInteger& midiNotes);
+    void handOver(juce::SynthesiserSound::Ptr sound, const SampleReference& reference);
+
+    /** Hands the last sound back with the new loop settings once they've settled. */
+    void reloop();
+    static juce::SynthesiserSound::Ptr withLoop(juce::SynthesiserSound::Ptr sound, const LoopSettings& settings);
+    bool shouldAbort() const;
+    SampleData::Ptr getSampleData(const juce::File& file, juce::AudioFormatReader& reader);
+
+    /** The sample as it's used, from the store or the cache, or null if it has to be
+        decoded. Always sets hash, from the store where it has the file.
+    */
+    SampleData::Ptr findSampleData(const juce::File& file, double sourceRate, juce::uint64& hash);
+
+    /** Converts decoded data to the target rate, if it isn't at it already. */
+    SampleData::Ptr toStoredRate(const juce::File& file, SampleData::Ptr decoded, juce::uint64 hash);
+
+    /** The rate a file at sourceRate is kept at, or 0 for its own. */
+    double getStoredRate(double sourceRate) const;
+    SampleData::Ptr getDecodedData(const juce::File& file, juce::AudioFormatReader& reader, juce::uint64 hash);
+
+    /** Decodes the frames of data that aren't ready yet, in parallel where it can, and
+        publishes them as it goes. Returns false if shouldAbort() stopped it first.
+    */
+    bool decodeInto(SampleData& data, const juce::File& file, juce::AudioFormatReader& reader);
+    SampleData::Ptr findCached(const juce::File& file, juce::uint64 hash, double resampledRate);
+    SampleData::Ptr addToCache(const juce::File& file, juce::uint64 hash, SampleData::Ptr data, double resampledRate);
+    /** The peaks of the file, from its peak file where it's up to date, else from data if it
+        isn't null, else read from the reader. A resampled data gets a pyramid of its own.
+    */
+    PeakPyramid::Ptr getPeaks(const juce::File& file, juce::AudioFormatReader& reader, const SampleData* data, bool resampled);
+    static bool isResampled(const SampleData& data, const juce::AudioFormatReader& reader);
+    bool hasPendingRequest() const;
+
+    /** Spreads the tasks over the decode pool and this thread. Anywhere but on the
+        loader thread itself, which is inside a pool job already, and from a task of
+        an outer call, they just run in turn.
+    */
+    void runInParallel(int numTasks, const std::function<void(int)>& task);
+
+    juce::AudioFormatManager mFormatManager;
+    DiskStreamer& mStreamer;
+    juce::SharedResourcePointer<SampleStore> mStore;
+    juce::SharedResourcePointer<SampleCache> mCache;
+
+    NonRealtimeLock mRequestLock;
+    juce::File mPendingFile;
+    bool mHasPendingFile{ false };
+
+    std::atomic<bool> mSavesPeakFiles{ true };
+    std::atomic<double> mTargetSampleRate{ 0.0 };
+    std::atomic<bool> mStreamingEnabled{ true };
+    std::atomic<bool> mUsesSampleCache{ true };
+    std::atomic<bool> mProgressiveLoading{ true };
+    std::atomic<bool> mParallelDecoding{ true };
+
+    // stored one by one, a torn read only means another reloop right after
+    std::atomic<int> mLoopMode{ (int) LoopMode::off };
+    std::atomic<float> mLoopStart{ LoopSettings{}.start }, mLoopEnd{ LoopSettings{}.end };
+    std::atomic<float> mLoopCrossfadeMs{ LoopSettings{}.crossfadeMs };
+    std::atomic<bool> mLoopChanged{ false };
+
+    // signalled for every request and loop change, the idle loader sleeps on it
+    RealtimeSemaphore mWake;
+
+    // the last sound handed back, loader thread only
+    juce::SynthesiserSound::Ptr mLastSound;
+    SampleReference mLastReference;
+    LoopSettings mLastLoop;
+
+    // one pool for the whole process, so a session with dozens of instances doesn't
+    // start a thread per core for each of them
+    struct DecodePool  : public juce::ThreadPool
+    {
+        DecodePool() : juce::ThreadPool(juce::jmax(1, juce::SystemStats::getNumCpus() - 1), 0, juce::Thread::Priority::low) {}
+    };
+
+    juce::SharedResourcePointer<DecodePool> mDecodePool;
+    juce::WaitableEvent mDecodeFinished;
+    std::atomic<int> mNumDecodeJobs{ 0 };
+    // set for the length of a parallel run, so a task that runs in parallel itself just runs
+    // its tasks in turn instead of resetting the jobs of the run it's part of. Loader thread only.
+    bool mRunningInParallel{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleLoader)
+};
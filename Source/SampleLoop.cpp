@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    SampleLoop.cpp
+    Created: 8 Mar 2025 3:52:40pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "SampleLoop.h"
+
+SampleLoop::SampleLoop(LoopMode mode, int start, int length, int crossfadeLength, SampleData::Ptr body)
+    : mMode(mode), mStart(start), mLength(length), mCrossfadeLength(crossfadeLength), mBody(std::move(body))
+{
+}
+
+SampleLoop::Ptr SampleLoop::build(const SampleData& data, const LoopSettings& settings)
+{
+    if (settings.mode == LoopMode::off)
+        return nullptr;
+
+    auto numFrames = data.getNumFrames();
+    auto start = juce::jlimit(0, numFrames, juce::roundToInt(settings.start * numFrames));
+    auto end = juce::jlimit(0, numFrames, juce::roundToInt(settings.end * numFrames));
+    auto length = end - start;
+
+    if (length < minLoopFrames)
+        return nullptr;
+
+    // the fade in comes from before the loop start, and the half of the body that
+    // isn't faded is where a voice can leave the loop
+    auto crossfadeLength = juce::roundToInt(settings.crossfadeMs * 0.001 * data.getSampleRate());
+    crossfadeLength = juce::jlimit(0, juce::jmin(start, length / 2), crossfadeLength);
+
+    auto view = data.getView();
+
+    auto body = SampleData::build(data.getName() + " loop", view.numChannels, length + 2 * leadFrames, data.getSampleRate(),
+                                  [&](float* const* channels) {
+        for (int ch = 0; ch < view.numChannels; ++ch) {
+            const auto* source = view.getChannel(ch) + start;
+            auto* dest = channels[ch] + leadFrames;
+
+            juce::FloatVectorOperations::copy(dest, source, length);
+
+            // linear, the two sides are usually the same sound a loop length apart
+            for (int i = 0; i < crossfadeLength; ++i) {
+                auto frame = length - crossfadeLength + i;
+                auto fadeIn = (float) (i + 1) / (float) crossfadeLength;
+
+                dest[frame] = source[frame] + fadeIn * (source[frame - length] - source[frame]);
+            }
+
+            juce::FloatVectorOperations::copy(dest - leadFrames, dest + length - leadFrames, leadFrames);
+            juce::FloatVectorOperations::copy(dest + length, dest, leadFrames);
+        }
+    });
+
+    return new SampleLoop(settings.mode, start, length, crossfadeLength, body);
+}
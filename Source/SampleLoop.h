@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    SampleLoop.h
+    Created: 8 Mar 2025 3:52:40pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleData.h"
+
+enum class LoopMode
+{
+    off = 0,
+    continuous,
+    untilRelease
+};
+
+//==============================================================================
+/** Where a sample loops, as set by the loop parameters. */
+struct LoopSettings
+{
+    LoopMode mode{ LoopMode::off };
+
+    /** Fractions of the sample's length. */
+    float start{ 0.25f }, end{ 1.0f };
+
+    float crossfadeMs{ 20.0f };
+
+    static juce::StringArray getModeNames() { return { "Off", "Continuous", "Until Release" }; }
+
+    bool operator==(const LoopSettings& other) const noexcept
+    {
+        return mode == other.mode && start == other.start && end == other.end && crossfadeMs == other.crossfadeMs;
+    }
+
+    bool operator!=(const LoopSettings& other) const noexcept { return !operator==(other); }
+};
+
+//==============================================================================
+/*
+    The looped part of a sample, laid out so a voice can play round it without
+    checking for the wrap on every frame.
+
+    The body is a copy of the frames from the loop start to the loop end, with
+    the last crossfade frames blended into the frames just before the loop start.
+    The end of the body then runs into its own first frame. Both sides of the body
+    get leadFrames frames of the body from the other end, so the interpolator can
+    read across the wrap in either direction.
+
+    A voice plays the sample itself up to the loop start, then the body from
+    leadFrames on, and steps back by the loop length whenever it passes the end.
+    All of that happens between chunks, the interpolation loops stay as they are.
+    Leaving the loop after the release, it goes back to the sample before the
+    crossfade starts, where the body and the sample are the same frames.
+*/
+class SampleLoop  : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<SampleLoop>;
+
+    static constexpr int leadFrames = SampleData::paddingFrames;
+
+    /** Loops shorter than this aren't built, they'd only buzz. */
+    static constexpr int minLoopFrames = 64;
+
+    static_assert(minLoopFrames >= leadFrames, "the lead is copied from a single lap of the body");
+
+    /** Copies the loop out of the data. Returns null if the settings are off or the
+        loop would be too short. Not on the audio thread.
+    */
+    static Ptr build(const SampleData& data, const LoopSettings& settings);
+
+    LoopMode getMode() const noexcept { return mMode; }
+
+    /** In frames of the sample. */
+    int getStart() const noexcept { return mStart; }
+    int getEnd() const noexcept { return mStart + mLength; }
+    int getLength() const noexcept { return mLength; }
+    int getCrossfadeLength() const noexcept { return mCrossfadeLength; }
+
+    /** The body, with the loop start at leadFrames. */
+    SampleView getView() const noexcept { return mBody->getView(); }
+
+    size_t getSizeInBytes() const noexcept { return mBody->getSizeInBytes(); }
+
+private:
+    SampleLoop(LoopMode mode, int start, int length, int crossfadeLength, SampleData::Ptr body);
+
+    const LoopMode mMode;
+    const int mStart, mLength, mCrossfadeLength;
+    const SampleData::Ptr mBody;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleLoop)
+};
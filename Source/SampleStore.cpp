@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    SampleStore.cpp
+    Created: 16 Nov 2024 3:20:41pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "SampleStore.h"
+
+bool SampleStore::Entry::matches(const juce::File& file) const
+{
+    // a file that was overwritten since it was decoded counts as a different file
+    return path == file.getFullPathName()
+        && modificationTime == file.getLastModificationTime()
+        && fileSize == file.getSize();
+}
+
+bool SampleStore::Entry::matches(const juce::File& file, double rate) const
+{
+    return resampledRate == rate && matches(file);
+}
+
+SampleData::Ptr SampleStore::find(const juce::File& file, double resampledRate) const
+{
+    const NonRealtimeLock::ScopedLockType sl(mLock);
+
+    for (const auto& entry : mEntries) {
+        if (entry.matches(file, resampledRate))
+            return entry.data;
+    }
+
+    return nullptr;
+}
+
+juce::uint64 SampleStore::findHash(const juce::File& file) const
+{
+    const NonRealtimeLock::ScopedLockType sl(mLock);
+
+    for (const auto& entry : mEntries) {
+        if (entry.matches(file))
+            return entry.contentHash;
+    }
+
+    return 0;
+}
+
+SampleData::Ptr SampleStore::add(const juce::File& file, juce::uint64 contentHash, SampleData::Ptr data, double resampledRate)
+{
+    const NonRealtimeLock::ScopedLockType sl(mLock);
+
+    for (const auto& entry : mEntries) {
+        if (entry.matches(file, resampledRate))
+            return entry.data;
+    }
+
+    mEntries.push_back({ file.getFullPathName(), file.getLastModificationTime(), file.getSize(), contentHash, resampledRate, data });
+    return data;
+}
+
+void SampleStore::purgeUnused()
+{
+    std::vector<SampleData::Ptr> unused;
+
+    {
+        const NonRealtimeLock::ScopedLockType sl(mLock);
+
+        for (auto it = mEntries.begin(); it != mEntries.end();) {
+            if (it->data->getReferenceCount() == 1) {
+                unused.push_back(std::move(it->data));
+                it = mEntries.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    // the buffers are freed here, outside the lock
+}
+
+size_t SampleStore::getTotalSizeInBytes() const
+{
+    const NonRealtimeLock::ScopedLockType sl(mLock);
+
+    size_t total = 0;
+
+    for (const auto& entry : mEntries)
+        total += entry.data->getSizeInBytes();
+
+    return total;
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    SampleStore.h
+    Created: 16 Nov 2024 3:20:41pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleData.h"
+#include "RealtimeGuard.h"
+
+//==============================================================================
+/*
+    Decoded samples, keyed by file. Every plugin instance in the process shares one
+    store (use it through a juce::SharedResourcePointer), so loading a file that is
+    already in memory just hands out another reference to the same SampleData.
+
+    A file converted to another rate at load time is a separate entry, keyed by
+    the rate it was converted to. A rate of 0 is the file as it was decoded.
+*/
+class SampleStore
+{
+public:
+    SampleStore() = default;
+
+    /** Returns the decoded file, or null if it isn't in the store. Any thread. */
+    SampleData::Ptr find(const juce::File& file, double resampledRate = 0.0) const;
+
+    /** The content hash the file was added with, at any rate, or 0 if it isn't in the store. */
+    juce::uint64 findHash(const juce::File& file) const;
+
+    /** Adds freshly decoded data, returns whatever ends up stored for the file.
+        If another thread got there first that copy wins and this one is dropped.
+    */
+    SampleData::Ptr add(const juce::File& file, juce::uint64 contentHash, SampleData::Ptr data, double resampledRate = 0.0);
+
+    /** Forgets every sample that nobody outside the store is using. */
+    void purgeUnused();
+
+    size_t getTotalSizeInBytes() const;
+
+private:
+    struct Entry
+    {
+        juce::String path;
+        juce::Time modificationTime;
+        juce::int64 fileSize;
+        juce::uint64 contentHash;
+        double resampledRate;
+        SampleData::Ptr data;
+
+        bool matches(const juce::File& file) const;
+        bool matches(const juce::File& file, double rate) const;
+    };
+
+    std::vector<Entry> mEntries;
+    NonRealtimeLock mLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleStore)
+};
@@ -0,0 +1,303 @@
+/*
+  ==============================================================================
+
+    SampleVoice.cpp
+    Created: 16 Nov 2024 4:05:12pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "SampleVoice.h"
+
+SampleSound::SampleSound(const juce::String& name, Keymap::Ptr keymap) : mName(name), mKeymap(std::move(keymap))
+{
+    jassert(mKeymap != nullptr && !mKeymap->getZones().empty());
+}
+
+SampleSound::SampleSound(SampleData::Ptr data, PeakPyramid::Ptr peaks, const juce::BigInteger& midiNotes, int midiNoteForNormalPitch)
+    : SampleSound(data->getName(), Keymap::forSample(data, std::move(peaks), midiNotes, midiNoteForNormalPitch))
+{
+}
+
+SampleSound::Ptr SampleSound::withLoop(const LoopSettings& settings) const
+{
+    auto zones = mKeymap->getZones();
+
+    // a sample that's still being decoded is looped once it's all there
+    for (auto& zone : zones)
+        zone.loop = zone.data->isComplete() ? SampleLoop::build(*zone.data, settings) : nullptr;
+
+    return new SampleSound(mName, new Keymap(std::move(zones)));
+}
+
+bool SampleSound::appliesToNote(int midiNoteNumber)
+{
+    return mKeymap->hasZonesFor(midiNoteNumber);
+}
+
+bool SampleSound::appliesToChannel(int /*midiChannel*/)
+{
+    return true;
+}
+
+//==============================================================================
+SampleVoice::~SampleVoice()
+{
+    releaseCachedEntry();
+}
+
+void SampleVoice::releaseCachedEntry() noexcept
+{
+    // the cache keeps its own reference, this never deletes
+    if (mCachedEntry != nullptr) {
+        mCachedEntry->decReferenceCountWithoutDeleting();
+        mCachedEntry = nullptr;
+    }
+}
+
+bool SampleVoice::canPlaySound(juce::SynthesiserSound* sound)
+{
+    return dynamic_cast<const SampleSound*>(sound) != nullptr;
+}
+
+void SampleVoice::startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound* s, int /*pitchWheel*/)
+{
+    releaseCachedEntry();
+
+    if (dynamic_cast<SampleSound*>(s) != nullptr) {
+        auto* zone = std::exchange(mNextZone, nullptr);
+
+        // the synthesiser only starts voices for zones that are there, see YellowRoseSynth::noteOn()
+        if (zone == nullptr) {
+            jassertfalse;
+            clearCurrentNote();
+            return;
+        }
+
+        // the sound keeps the data and the loop alive for as long as this note is playing
+        mSampleView = zone->data->getView();
+        mView = mSampleView;
+        mLoop = zone->loop.get();
+        mSegment = mLoop != nullptr ? Segment::toLoop : Segment::toEnd;
+        mIsReleased = false;
+        mIsWaitingForDecoder = false;
+
+        auto pitchRatio = std::pow(2.0, (midiNoteNumber - zone->rootNote + zone->tuneSemitones) / 12.0)
+                            * mView.sampleRate / getSampleRate();
+
+        // a copy pre-rendered at this ratio plays frame for frame, fully decoded one-shots only.
+        // A bend steps through the copy, relative to the pitch it was rendered at.
+        if (mPitchCache != nullptr && pitchRatio != 1.0 && mLoop == nullptr && zone->data->isComplete()) {
+            mCachedEntry = mPitchCache->find(zone->data.get(), pitchRatio, mInterpolation);
+
+            if (mCachedEntry != nullptr) {
+                mView = mCachedEntry->getView();
+                pitchRatio = 1.0;
+            }
+        }
+
+        setUnbentPitchRatio(pitchRatio);
+
+        mSourceSamplePosition = 0.0;
+        mGain = velocity * zone->gain;
+        mOutputBus = zone->outputBus;
+
+        mEnvelope.noteOn();
+        startFilter(midiNoteNumber);
+    }
+    else {
+        jassertfalse; // this object can only play SampleSounds!
+    }
+}
+
+void SampleVoice::stopNote(float /*velocity*/, bool allowTailOff)
+{
+    if (allowTailOff) {
+        mIsReleased = true;
+        mEnvelope.noteOff();
+        releaseFilter();
+    }
+    else {
+        clearCurrentNote();
+        mEnvelope.reset();
+        releaseCachedEntry();
+        mDisplayPosition.store(-1.0f, std::memory_order_relaxed);
+    }
+}
+
+double SampleVoice::getSegmentEnd() const noexcept
+{
+    switch (mSegment) {
+    case Segment::toLoop:
+        return mLoop->getStart();
+
+    case Segment::loop: {
+        auto wrap = (double) (SampleLoop::leadFrames + mLoop->getLength());
+
+        if (!mIsReleased || mLoop->getMode() != LoopMode::untilRelease)
+            return wrap;
+
+        // out where the body is still the sample, or round once more if that's passed already
+        auto exit = wrap - mLoop->getCrossfadeLength();
+        return mSourceSamplePosition < exit ? exit : wrap;
+    }
+
+    case Segment::toEnd:
+        break;
+    }
+
+    // while the sample is still being decoded, stop short enough that the widest kernel stays in what's there
+    auto numFramesReady = mView.getNumFramesReady();
+
+    if (numFramesReady < mView.numFrames)
+        return (double) (numFramesReady - SampleData::paddingFrames);
+
+    // the last interpolation point mustn't run off the end
+    return mView.numFrames - 1;
+}
+
+bool SampleVoice::nextSegment() noexcept
+{
+    switch (mSegment) {
+    case Segment::toLoop:
+        mSegment = Segment::loop;
+        mView = mLoop->getView();
+        mSourceSamplePosition += SampleLoop::leadFrames - mLoop->getStart();
+        return true;
+
+    case Segment::loop: {
+        auto wrap = (double) (SampleLoop::leadFrames + mLoop->getLength());
+
+        // before the wrap means at the exit, past it is only as good without a crossfade
+        auto isAtExit = mSourceSamplePosition < wrap || mLoop->getCrossfadeLength() == 0;
+
+        if (mIsReleased && mLoop->getMode() == LoopMode::untilRelease && isAtExit) {
+            mSegment = Segment::toEnd;
+            mView = mSampleView;
+            mSourceSamplePosition += mLoop->getStart() - SampleLoop::leadFrames;
+            return true;
+        }
+
+        // the remainder rather than one length back, so a step longer than the loop can't stall
+        mSourceSamplePosition = SampleLoop::leadFrames + std::fmod(mSourceSamplePosition - SampleLoop::leadFrames, (double) mLoop->getLength());
+        return true;
+    }
+
+    case Segment::toEnd:
+        break;
+    }
+
+    return false;
+}
+
+void SampleVoice::controllerMoved(int /*controllerNumber*/, int /*newValue*/) {}
+
+void SampleVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+{
+    if (getCurrentlyPlayingSound() == nullptr)
+        return;
+
+    // a mono sample is resampled once and used for both sides
+    const bool isStereoSource = mView.numChannels > 1;
+
+    float* outL = outputBuffer.getWritePointer(0, startSample);
+    float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer(1, startSample) : nullptr;
+
+    alignas(32) float left[chunkSize];
+    alignas(32) float right[chunkSize];
+    alignas(32) float envelope[chunkSize];
+
+    while (numSamples > 0) {
+        // how many frames until the last interpolation point would pass the end of the segment
+        auto framesLeft = std::ceil((getSegmentEnd() - mSourceSamplePosition) / mPitchRatio);
+        auto numThisTime = (int) juce::jmin((double) juce::jmin(numSamples, chunkSize), framesLeft);
+
+        if (numThisTime <= 0) {
+            if (nextSegment())
+                continue;
+
+            // caught up with the decoder. The note keeps time in silence, and comes back in
+            // wherever it has got to once the decoder is further along.
+            if (mSegment == Segment::toEnd && mView.getNumFramesReady() < mView.numFrames) {
+                auto numSilent = juce::jmin(numSamples, chunkSize);
+
+                mEnvelope.getNextBlock(envelope, numSilent);
+                mLevel = 0.0f;
+                mIsWaitingForDecoder = true;
+
+                outL += numSilent;
+                outR = outR != nullptr ? outR + numSilent : nullptr;
+                numSamples -= numSilent;
+                mSourceSamplePosition += numSilent * mPitchRatio;
+
+                if (!mEnvelope.isActive()) {
+                    stopNote(0.0f, false);
+                    break;
+                }
+
+                continue;
+            }
+
+            stopNote(0.0f, false);
+            break;
+        }
+
+        // ends where the decoder has got to, unless it moves on before the next block
+        auto isAtDecoderEdge = mSegment == Segment::toEnd && (double) numThisTime == framesLeft
+                                 && mView.getNumFramesReady() < mView.numFrames;
+
+        Interpolator::process(mInterpolation, mView.getChannel(0), mSourceSamplePosition, mPitchRatio, left, numThisTime);
+
+        if (isStereoSource)
+            Interpolator::process(mInterpolation, mView.getChannel(1), mSourceSamplePosition, mPitchRatio, right, numThisTime);
+
+        const float* rightSource = isStereoSource ? right : left;
+
+        mEnvelope.getNextBlock(envelope, numThisTime);
+        juce::FloatVectorOperations::multiply(envelope, mGain, numThisTime);
+
+        // faded out and back in over a chunk, rather than cut
+        if (std::exchange(mIsWaitingForDecoder, false))
+            applyRamp(envelope, numThisTime, 0.0f, 1.0f);
+
+        if (isAtDecoderEdge) {
+            applyRamp(envelope, numThisTime, 1.0f, 0.0f);
+            mIsWaitingForDecoder = true;
+        }
+
+        mLevel = envelope[numThisTime - 1];
+
+        if (outR != nullptr) {
+            juce::FloatVectorOperations::addWithMultiply(outL, left, envelope, numThisTime);
+            juce::FloatVectorOperations::addWithMultiply(outR, rightSource, envelope, numThisTime);
+            outR += numThisTime;
+        }
+        else {
+            juce::FloatVectorOperations::multiply(envelope, 0.5f, numThisTime);
+            juce::FloatVectorOperations::addWithMultiply(outL, left, envelope, numThisTime);
+            juce::FloatVectorOperations::addWithMultiply(outL, rightSource, envelope, numThisTime);
+        }
+
+        outL += numThisTime;
+        numSamples -= numThisTime;
+        mSourceSamplePosition += numThisTime * mPitchRatio;
+
+        if (!mEnvelope.isActive()) {
+            stopNote(0.0f, false);
+            break;
+        }
+    }
+
+    if (isVoiceActive())
+        mDisplayPosition.store(getSamplePosition(), std::memory_order_relaxed);
+}
+
+float SampleVoice::getSamplePosition() const noexcept
+{
+    // the loop body starts its own count, a cached copy is the whole sample at another length
+    if (mSegment == Segment::loop)
+        return (float) ((mLoop->getStart() + mSourceSamplePosition - SampleLoop::leadFrames) / mSampleView.numFrames);
+
+    return (float) (mSourceSamplePosition / mView.numFrames);
+}
@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    SampleVoice.h
+    Created: 16 Nov 2024 4:05:12pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleData.h"
+#include "PeakPyramid.h"
+#include "Interpolator.h"
+#include "Keymap.h"
+#include "PitchCache.h"
+#include "YellowRoseVoice.h"
+
+//==============================================================================
+/*
+    A sound that plays fully decoded audio. Unlike juce::SamplerSound it doesn't
+    own a private copy, it references shared SampleData.
+
+    The samples are laid out by a Keymap, which for a single file is one zone
+    over the whole keyboard.
+*/
+class SampleSound  : public juce::SynthesiserSound
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<SampleSound>;
+
+    SampleSound(const juce::String& name, Keymap::Ptr keymap);
+    SampleSound(SampleData::Ptr data, PeakPyramid::Ptr peaks, const juce::BigInteger& midiNotes, int midiNoteForNormalPitch);
+
+    const juce::String& getName() const noexcept { return mName; }
+    Keymap& getKeymap() const noexcept { return *mKeymap; }
+
+    /** The first zone's sample, which is the one the thumbnail shows. */
+    const SampleData::Ptr& getData() const noexcept { return mKeymap->getZones().front().data; }
+    const PeakPyramid::Ptr& getPeaks() const noexcept { return mKeymap->getZones().front().peaks; }
+
+    /** A sound with the same zones, each looped as the settings say. The samples are
+        shared, only the loop bodies are new. Not on the audio thread.
+    */
+    Ptr withLoop(const LoopSettings& settings) const;
+
+    bool appliesToNote(int midiNoteNumber) override;
+    bool appliesToChannel(int midiChannel) override;
+
+private:
+    juce::String mName;
+    Keymap::Ptr mKeymap;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleSound)
+};
+
+//==============================================================================
+/*
+    Plays a SampleSound straight out of its shared SampleData. Renders in chunks:
+    resample each channel with the Interpolator, then apply envelope and gain and
+    mix with vector operations, so nothing in the per-sample loops branches.
+
+    A looped zone plays in segments: the sample up to the loop start, then the
+    loop body round and round, and for loops that end on release, the rest of the
+    sample. Chunks are cut short at the end of a segment and the next chunk reads
+    from the next one, see SampleLoop.
+*/
+class SampleVoice  : public YellowRoseVoice
+{
+public:
+    static constexpr int chunkSize = 64;
+
+    SampleVoice() { mRendersInVoiceBank = true; }
+    ~SampleVoice() override;
+
+    /** Safe to call from the audio thread, takes effect at the next block. */
+    void setInterpolation(InterpolationMode mode) noexcept { mInterpolation = mode; }
+
+    /** Notes at a ratio the cache has a copy for play that copy. The cache must outlive the voice. */
+    void setPitchCache(PitchCache* cache) noexcept { mPitchCache = cache; }
+
+    /** The zone the next startNote() plays, set by the synthesiser right before it
+        starts the voice. A note on a SampleSound without one doesn't play.
+    */
+    void setNextZone(const KeyZone* zone) noexcept { mNextZone = zone; }
+
+    bool canPlaySound(juce::SynthesiserSound* sound) override;
+
+    void startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound* sound, int pitchWheel) override;
+    void stopNote(float velocity, bool allowTailOff) override;
+
+    void controllerMoved(int controllerNumber, int newValue) override;
+
+    void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override;
+    using YellowRoseVoice::renderNextBlock;
+
+private:
+    // renders the steady part of the note from the same state, see VoiceBank
+    friend class VoiceBank;
+
+    enum class Segment
+    {
+        toLoop,
+        loop,
+        toEnd
+    };
+
+    void releaseCachedEntry() noexcept;
+
+    /** Where the current segment runs out, in frames of mView. */
+    double getSegmentEnd() const noexcept;
+
+    /** Moves on at the end of a segment. Returns false once the sample has run out. */
+    bool nextSegment() noexcept;
+
+    /** From 0 to 1 through the zone's sample. */
+    float getSamplePosition() const noexcept;
+
+    SampleView mView;
+
+    // the zone's sample and loop, mView is either one of them or a cached copy
+    SampleView mSampleView;
+    const SampleLoop* mLoop{ nullptr };
+    Segment mSegment{ Segment::toEnd };
+    bool mIsReleased{ false };
+
+    // faded out where a sample that's still being decoded ran out, the next chunk played fades in
+    bool mIsWaitingForDecoder{ false };
+
+    const KeyZone* mNextZone{ nullptr };
+    PitchCache* mPitchCache{ nullptr };
+    PitchCache::Entry* mCachedEntry{ nullptr };
+
+    InterpolationMode mInterpolation{ InterpolationMode::cubic };
+
+    float mGain{ 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleVoice)
+};
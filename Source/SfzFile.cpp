@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+    SfzFile.cpp
+    Created: 4 Jan 2025 2:40:07pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "SfzFile.h"
+
+namespace
+{
+    using Opcodes = std::map<juce::String, juce::String>;
+
+    SfzFile::Region createRegion(const juce::File& sfz, const Opcodes& opcodes)
+    {
+        SfzFile::Region region;
+
+        auto get = [&](const char* name) -> juce::String {
+            auto it = opcodes.find(name);
+            return it != opcodes.end() ? it->second : juce::String();
+        };
+
+        auto note = [&](const char* name, int fallback) {
+            auto value = SfzFile::parseNote(get(name));
+            return value >= 0 ? value : fallback;
+        };
+
+        auto path = (get("default_path") + get("sample")).replaceCharacter('\\', '/');
+
+        if (path.isNotEmpty())
+            region.sample = sfz.getParentDirectory().getChildFile(path);
+
+        // key= sets all three, the specific opcodes override it
+        auto key = note("key", -1);
+
+        if (key >= 0)
+            region.lowNote = region.highNote = region.rootNote = key;
+
+        region.lowNote = note("lokey", region.lowNote);
+        region.highNote = note("hikey", region.highNote);
+        region.rootNote = note("pitch_keycenter", region.rootNote);
+
+        if (opcodes.count("lovel") > 0)
+            region.lowVelocity = juce::jlimit(0, 127, get("lovel").getIntValue());
+
+        if (opcodes.count("hivel") > 0)
+            region.highVelocity = juce::jlimit(0, 127, get("hivel").getIntValue());
+
+        if (opcodes.count("seq_position") > 0)
+            region.sequencePosition = get("seq_position").getIntValue();
+
+        region.volumeDecibels = get("volume").getFloatValue();
+        region.tuneCents = get("tune").getFloatValue();
+        region.transpose = get("transpose").getIntValue();
+        region.output = juce::jmax(0, get("output").getIntValue());
+
+        return region;
+    }
+}
+
+//==============================================================================
+std::vector<SfzFile::Region> SfzFile::read(const juce::File& file)
+{
+    std::vector<Region> regions;
+
+    // control, global, master, group, region; a header clears its own level and those below
+    std::array<Opcodes, 5> levels;
+    int level = -1;
+
+    auto finishRegion = [&] {
+        if (level != 4)
+            return;
+
+        Opcodes merged;
+
+        for (auto& opcodes : levels) {
+            for (auto& [name, value] : opcodes)
+                merged[name] = value;
+        }
+
+        auto region = createRegion(file, merged);
+
+        if (region.sample != juce::File())
+            regions.push_back(region);
+    };
+
+    juce::StringArray lines;
+    file.readLines(lines);
+
+    juce::String lastOpcode;
+
+    for (auto line : lines) {
+        line = line.upToFirstOccurrenceOf("//", false, false);
+
+        // headers may sit right against opcodes
+        auto tokens = juce::StringArray::fromTokens(line.replace("<", " <").replace(">", "> "), " \t", "");
+
+        for (auto& token : tokens) {
+            if (token.startsWithChar('<')) {
+                static const juce::StringArray headers{ "<control>", "<global>", "<master>", "<group>", "<region>" };
+
+                finishRegion();
+                lastOpcode.clear();
+
+                auto header = headers.indexOf(token.trim(), true);
+
+                // unknown headers, like <curve> or <effect>, don't affect the mapping
+                if (header < 0) {
+                    level = -1;
+                    continue;
+                }
+
+                level = header;
+
+                for (int i = level; i < (int) levels.size(); ++i)
+                    levels[(size_t) i].clear();
+            }
+            else if (level >= 0 && token.containsChar('=')) {
+                lastOpcode = token.upToFirstOccurrenceOf("=", false, false).toLowerCase();
+                levels[(size_t) level][lastOpcode] = token.fromFirstOccurrenceOf("=", false, false);
+            }
+            else if (level >= 0 && lastOpcode.isNotEmpty()) {
+                // sample paths may contain spaces
+                levels[(size_t) level][lastOpcode] << " " << token;
+            }
+        }
+
+        // a value never carries on to the next line
+        lastOpcode.clear();
+    }
+
+    finishRegion();
+    return regions;
+}
+
+int SfzFile::parseNote(const juce::String& text)
+{
+    auto trimmed = text.trim().toLowerCase();
+
+    if (trimmed.isEmpty())
+        return -1;
+
+    if (trimmed.containsOnly("-0123456789"))
+        return juce::jlimit(-1, 127, trimmed.getIntValue());
+
+    static const int semitones[] = { 9, 11, 0, 2, 4, 5, 7 }; // a to g
+    auto letter = trimmed[0];
+
+    if (letter < 'a' || letter > 'g')
+        return -1;
+
+    auto note = semitones[letter - 'a'];
+    auto rest = trimmed.substring(1);
+
+    if (rest.startsWithChar('#')) {
+        ++note;
+        rest = rest.substring(1);
+    }
+    else if (rest.startsWithChar('b')) {
+        --note;
+        rest = rest.substring(1);
+    }
+
+    if (rest.isEmpty() || !rest.containsOnly("-0123456789"))
+        return -1;
+
+    auto midiNote = (rest.getIntValue() + 1) * 12 + note;
+    return juce::isPositiveAndBelow(midiNote, 128) ? midiNote : -1;
+}
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    SfzFile.h
+    Created: 4 Jan 2025 2:40:07pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Reads the mapping part of an SFZ instrument: which sample plays on which keys
+    and velocities, its root key, round-robin position, volume, tuning and the
+    stereo output it goes to.
+    <control>, <global>, <master> and <group> opcodes are inherited by the regions
+    below them. Everything else in the file is ignored.
+*/
+struct SfzFile
+{
+    struct Region
+    {
+        juce::File sample;
+
+        int lowNote{ 0 }, highNote{ 127 }, rootNote{ 60 };
+        int lowVelocity{ 0 }, highVelocity{ 127 };
+        int sequencePosition{ 1 };
+
+        float volumeDecibels{ 0.0f };
+        float tuneCents{ 0.0f };
+        int transpose{ 0 };
+
+        /** ARIA's output=, the stereo output pair counting from 0 for the main one. */
+        int output{ 0 };
+    };
+
+    /** Regions without a sample are left out. Empty if the file can't be read. */
+    static std::vector<Region> read(const juce::File& file);
+
+    /** A MIDI note number or a note name like c4, f#3 or eb-1, with c4 as 60. Returns -1 if it's neither. */
+    static int parseNote(const juce::String& text);
+};
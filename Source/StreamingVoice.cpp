@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+    StreamingVoice.cpp
+    Created: 9 Nov 2024 4:02:45pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "StreamingVoice.h"
+
+StreamingSound::StreamingSound(const juce::String& name,
+                               const juce::File& file,
+                               juce::AudioFormatReader& source,
+                               const juce::BigInteger& midiNotes,
+                               int midiNoteForNormalPitch,
+                               DiskStreamer& streamer,
+                               PeakPyramid::Ptr peaks,
+                               int headLength)
+    : mName(name), mFile(file), mStreamer(streamer), mPeaks(std::move(peaks)), mMidiNotes(midiNotes), mMidiRootNote(midiNoteForNormalPitch)
+{
+    mSourceSampleRate = source.sampleRate;
+    mLength = source.lengthInSamples;
+    mHeadLength = (int) juce::jmin((juce::int64) headLength, mLength);
+
+    mHead = SampleData::fromReader(name, source, (juce::int64) mHeadLength + 1);
+}
+
+StreamingSound::~StreamingSound()
+{
+    mStreamer.soundDeleted(this);
+}
+
+bool StreamingSound::appliesToNote(int midiNoteNumber)
+{
+    return mMidiNotes[midiNoteNumber];
+}
+
+bool StreamingSound::appliesToChannel(int /*midiChannel*/)
+{
+    return true;
+}
+
+//==============================================================================
+StreamingVoice::StreamingVoice(DiskStreamer& streamer) : mStream(streamer.createStream())
+{
+}
+
+bool StreamingVoice::canPlaySound(juce::SynthesiserSound* sound)
+{
+    return dynamic_cast<const StreamingSound*>(sound) != nullptr;
+}
+
+void StreamingVoice::startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound* s, int /*pitchWheel*/)
+{
+    if (auto* sound = dynamic_cast<StreamingSound*>(s)) {
+        setUnbentPitchRatio(std::pow(2.0, (midiNoteNumber - sound->getMidiRootNote()) / 12.0)
+                              * sound->getSourceSampleRate() / getSampleRate());
+
+        mSourceSamplePosition = 0.0;
+        mLeftGain = velocity;
+        mRightGain = velocity;
+        mOutputBus = 0;
+        mIsWaitingForDisk = false;
+
+        mStream->start(sound);
+
+        mEnvelope.noteOn();
+        startFilter(midiNoteNumber);
+    }
+    else {
+        jassertfalse; // this object can only play StreamingSounds!
+    }
+}
+
+void StreamingVoice::stopNote(float /*velocity*/, bool allowTailOff)
+{
+    if (allowTailOff) {
+        mEnvelope.noteOff();
+        releaseFilter();
+    }
+    else {
+        endNote();
+        mEnvelope.reset();
+    }
+}
+
+void StreamingVoice::controllerMoved(int /*controllerNumber*/, int /*newValue*/) {}
+
+void StreamingVoice::endNote()
+{
+    mStream->stop();
+    clearCurrentNote();
+    mDisplayPosition.store(-1.0f, std::memory_order_relaxed);
+}
+
+void StreamingVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+{
+    auto* playingSound = static_cast<StreamingSound*>(getCurrentlyPlayingSound().get());
+
+    if (playingSound == nullptr)
+        return;
+
+    const auto head = playingSound->getHead()->getView();
+    const auto headLength = (juce::int64) playingSound->getHeadLength();
+    const auto length = playingSound->getLength();
+
+    const float* const inL = head.getChannel(0);
+    const float* const inR = head.numChannels > 1 ? head.getChannel(1) : nullptr;
+
+    float* outL = outputBuffer.getWritePointer(0, startSample);
+    float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer(1, startSample) : nullptr;
+
+    alignas(32) float left[chunkSize];
+    alignas(32) float right[chunkSize];
+    alignas(32) float envelope[chunkSize];
+
+    mStream->beginRead();
+
+    // the head keeps one frame past its length, so it always has the second point for its last frame
+    const auto endOfFile = (double) (length - 1);
+    const auto streamed = (double) juce::jmax(headLength, mStream->getReadyEnd() - 1);
+    const auto playable = juce::jmin(endOfFile, streamed);
+
+    // an underrun is counted once per block, however many chunks it lasts
+    bool isStarved = false;
+
+    while (numSamples > 0) {
+        auto framesLeft = std::ceil((playable - mSourceSamplePosition) / mPitchRatio);
+        auto numThisTime = (int) juce::jmin((double) juce::jmin(numSamples, chunkSize), framesLeft);
+
+        if (numThisTime <= 0) {
+            // at the end of the file, or it ran past it while the disk was behind
+            if (streamed >= endOfFile || mSourceSamplePosition >= endOfFile) {
+                endNote();
+                break;
+            }
+
+            // the disk hasn't caught up. The note keeps time in silence rather than falling
+            // behind, and the frames it skips are handed back below as if it had played them.
+            auto numSilent = juce::jmin(numSamples, chunkSize);
+
+            if (!std::exchange(isStarved, true))
+                mStream->reportUnderrun();
+
+            mEnvelope.getNextBlock(envelope, numSilent);
+            mLevel = 0.0f;
+            mIsWaitingForDisk = true;
+
+            outL += numSilent;
+            outR = outR != nullptr ? outR + numSilent : nullptr;
+            numSamples -= numSilent;
+            mSourceSamplePosition += numSilent * mPitchRatio;
+
+            if (!mEnvelope.isActive()) {
+                endNote();
+                break;
+            }
+
+            continue;
+        }
+
+        // ends at the last frame the disk has delivered, unless more arrives before the next block
+        auto isAtDiskEdge = streamed < endOfFile && (double) numThisTime == framesLeft;
+        auto pos = mSourceSamplePosition;
+
+        for (int i = 0; i < numThisTime; ++i, pos += mPitchRatio) {
+            auto index = (juce::int64) pos;
+            auto alpha = (float) (pos - (double) index);
+            float l0, r0, l1, r1;
+
+            if (index < headLength) {
+                l0 = inL[index];
+                l1 = inL[index + 1];
+                r0 = inR != nullptr ? inR[index] : l0;
+                r1 = inR != nullptr ? inR[index + 1] : l1;
+            }
+            else {
+                // both are before the edge worked out above, so they're there
+                mStream->getFrame(index, l0, r0);
+                mStream->getFrame(index + 1, l1, r1);
+            }
+
+            left[i] = (l0 + alpha * (l1 - l0)) * mLeftGain;
+            right[i] = (r0 + alpha * (r1 - r0)) * mRightGain;
+        }
+
+        mEnvelope.getNextBlock(envelope, numThisTime);
+
+        // faded out and back in over a chunk, rather than cut
+        if (std::exchange(mIsWaitingForDisk, false))
+            applyRamp(envelope, numThisTime, 0.0f, 1.0f);
+
+        if (isAtDiskEdge) {
+            applyRamp(envelope, numThisTime, 1.0f, 0.0f);
+            mIsWaitingForDisk = true;
+        }
+
+        mLevel = envelope[numThisTime - 1] * mLeftGain;
+
+        if (outR != nullptr) {
+            juce::FloatVectorOperations::addWithMultiply(outL, left, envelope, numThisTime);
+            juce::FloatVectorOperations::addWithMultiply(outR, right, envelope, numThisTime);
+            outR += numThisTime;
+        }
+        else {
+            juce::FloatVectorOperations::multiply(envelope, 0.5f, numThisTime);
+            juce::FloatVectorOperations::addWithMultiply(outL, left, envelope, numThisTime);
+            juce::FloatVectorOperations::addWithMultiply(outL, right, envelope, numThisTime);
+        }
+
+        outL += numThisTime;
+        numSamples -= numThisTime;
+        mSourceSamplePosition += numThisTime * mPitchRatio;
+
+        if (!mEnvelope.isActive()) {
+            endNote();
+            break;
+        }
+    }
+
+    if (isVoiceActive()) {
+        mStream->releaseBefore((juce::int64) mSourceSamplePosition);
+        mDisplayPosition.store((float) (mSourceSamplePosition / (double) length), std::memory_order_relaxed);
+    }
+}
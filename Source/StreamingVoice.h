@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    StreamingVoice.h
+    Created: 9 Nov 2024 4:02:45pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DiskStreamer.h"
+#include "SampleData.h"
+#include "PeakPyramid.h"
+#include "YellowRoseVoice.h"
+
+//==============================================================================
+/*
+    A sound that only keeps the first few seconds of its file in memory. The rest
+    is read from disk by the DiskStreamer while a StreamingVoice is playing it.
+*/
+class StreamingSound  : public juce::SynthesiserSound
+{
+public:
+    static constexpr int defaultHeadLength = 1 << 16;
+
+    StreamingSound(const juce::String& name,
+                   const juce::File& file,
+                   juce::AudioFormatReader& source,
+                   const juce::BigInteger& midiNotes,
+                   int midiNoteForNormalPitch,
+                   DiskStreamer& streamer,
+                   PeakPyramid::Ptr peaks,
+                   int headLength = defaultHeadLength);
+    ~StreamingSound() override;
+
+    const juce::String& getName() const noexcept { return mName; }
+    const juce::File& getFile() const noexcept { return mFile; }
+
+    /** The preloaded start of the sample, with one extra frame for interpolation. */
+    const SampleData::Ptr& getHead() const noexcept { return mHead; }
+    int getHeadLength() const noexcept { return mHeadLength; }
+
+    /** Covers the whole file, not just the head. */
+    const PeakPyramid::Ptr& getPeaks() const noexcept { return mPeaks; }
+
+    juce::int64 getLength() const noexcept { return mLength; }
+    double getSourceSampleRate() const noexcept { return mSourceSampleRate; }
+    int getMidiRootNote() const noexcept { return mMidiRootNote; }
+
+    bool appliesToNote(int midiNoteNumber) override;
+    bool appliesToChannel(int midiChannel) override;
+
+private:
+    juce::String mName;
+    juce::File mFile;
+    DiskStreamer& mStreamer;
+
+    SampleData::Ptr mHead;
+    PeakPyramid::Ptr mPeaks;
+    int mHeadLength{ 0 };
+    juce::int64 mLength{ 0 };
+    double mSourceSampleRate{ 0.0 };
+
+    juce::BigInteger mMidiNotes;
+    int mMidiRootNote{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingSound)
+};
+
+//==============================================================================
+/*
+    Plays a StreamingSound: from the preloaded head first, then from the voice's
+    DiskStreamer ring. If the disk falls behind, the voice fades out at the last
+    frame that was streamed in and counts an underrun. It keeps time in silence
+    and fades back in at wherever the note has got to once the disk catches up.
+*/
+class StreamingVoice  : public YellowRoseVoice
+{
+public:
+    StreamingVoice(DiskStreamer& streamer);
+
+    bool canPlaySound(juce::SynthesiserSound* sound) override;
+
+    void startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound* sound, int pitchWheel) override;
+    void stopNote(float velocity, bool allowTailOff) override;
+
+    void controllerMoved(int controllerNumber, int newValue) override;
+
+    void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override;
+    using YellowRoseVoice::renderNextBlock;
+
+private:
+    static constexpr int chunkSize = 64;
+
+    void endNote();
+
+    DiskStreamer::Stream* mStream{ nullptr };
+
+    float mLeftGain{ 0.0f }, mRightGain{ 0.0f };
+    bool mIsWaitingForDisk{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingVoice)
+};
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    Telemetry.cpp
+    Created: 22 Feb 2025 10:14:52am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "Telemetry.h"
+
+juce::String Telemetry::Snapshot::toString() const
+{
+    juce::String text;
+    text << "sample rate: " << sampleRate << "\n"
+         << "blocks: " << numBlocks << "\n"
+         << "deadline misses: " << numDeadlineMisses << "\n"
+         << "last block: " << juce::String(lastBlockMs, 3) << " ms\n"
+         << "worst block: " << juce::String(worstBlockMs, 3) << " ms\n"
+         << "load: " << juce::String(lastLoad * 100.0, 1) << "% last, "
+                     << juce::String(getAverageLoad() * 100.0, 1) << "% average, "
+                     << juce::String(peakLoad * 100.0, 1) << "% peak\n"
+         << "active voices: " << activeVoices << ", peak " << peakActiveVoices << "\n"
+         << "parameter changes per block: " << parameterChanges << ", peak " << peakParameterChanges << "\n"
+         << "block durations:\n";
+
+    for (int bucket = 0; bucket < numBuckets; ++bucket)
+        text << "  " << getBucketName(bucket).paddedRight(' ', 16) << durations[bucket] << "\n";
+
+    return text;
+}
+
+bool Telemetry::Snapshot::writeTo(const juce::File& file) const
+{
+    return file.getParentDirectory().createDirectory()
+        && file.replaceWithText("YellowRose telemetry, " + juce::Time::getCurrentTime().toString(true, true) + "\n\n" + toString());
+}
+
+juce::String Telemetry::getBucketName(int bucket)
+{
+    auto formatMicroseconds = [](int us) {
+        return us < 1000 ? juce::String(us) + " us" : juce::String(us / 1000.0, us < 10000 ? 1 : 0) + " ms";
+    };
+
+    if (bucket == 0)
+        return "< " + formatMicroseconds(2);
+
+    if (bucket == numBuckets - 1)
+        return ">= " + formatMicroseconds(1 << bucket);
+
+    return formatMicroseconds(1 << bucket) + " - " + formatMicroseconds(1 << (bucket + 1));
+}
+
+juce::File Telemetry::getDumpDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("YellowRose").getChildFile("Telemetry");
+}
+
+void Telemetry::prepare(double sampleRate)
+{
+    mCurrent = {};
+    mCurrent.sampleRate = sampleRate;
+    mResetRequested.store(false, std::memory_order_relaxed);
+}
+
+void Telemetry::blockFinished(juce::int64 startTicks, int numSamples, int activeVoices, int parameterChanges) noexcept
+{
+    auto seconds = (double) (juce::Time::getHighResolutionTicks() - startTicks) / mTicksPerSecond;
+
+    if (mResetRequested.exchange(false, std::memory_order_relaxed)) {
+        auto sampleRate = mCurrent.sampleRate;
+        mCurrent = {};
+        mCurrent.sampleRate = sampleRate;
+    }
+
+    auto& s = mCurrent;
+    auto load = s.sampleRate > 0.0 && numSamples > 0 ? seconds * s.sampleRate / numSamples : 0.0;
+    auto microseconds = (juce::uint32) juce::jmin(seconds * 1.0e6, (double) std::numeric_limits<juce::uint32>::max());
+
+    ++s.numBlocks;
+    ++s.durations[juce::jmin(numBuckets - 1, juce::findHighestSetBit(juce::jmax(1u, microseconds)))];
+
+    if (load > 1.0)
+        ++s.numDeadlineMisses;
+
+    s.lastBlockMs = seconds * 1000.0;
+    s.worstBlockMs = juce::jmax(s.worstBlockMs, s.lastBlockMs);
+    s.lastLoad = load;
+    s.peakLoad = juce::jmax(s.peakLoad, load);
+    s.totalLoad += load;
+    s.activeVoices = activeVoices;
+    s.peakActiveVoices = juce::jmax(s.peakActiveVoices, activeVoices);
+    s.parameterChanges = parameterChanges;
+    s.peakParameterChanges = juce::jmax(s.peakParameterChanges, parameterChanges);
+
+    // a plain copy into the slot only this thread touches, then swapped into the middle
+    mSlots[mBack] = s;
+    mBack = mMiddle.exchange(mBack | freshBit, std::memory_order_acq_rel) & 3;
+}
+
+Telemetry::Snapshot Telemetry::getSnapshot() noexcept
+{
+    if (mMiddle.load(std::memory_order_relaxed) & freshBit)
+        mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & 3;
+
+    return mSlots[mFront];
+}
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    Telemetry.h
+    Created: 22 Feb 2025 10:14:52am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    What processBlock has been doing: how long the blocks took against their
+    deadline, how many voices played and how many parameter changes each block
+    picked up.
+
+    The audio thread adds each block to a snapshot of its own and publishes a
+    copy through a triple buffer, so neither side ever waits for the other and
+    nothing is allocated or locked. The reader always gets the latest complete
+    snapshot. There can only be one reader at a time, the editor reads from the
+    message thread.
+*/
+class Telemetry
+{
+public:
+    /** Block durations in powers of two microseconds, from under 2 us to 32 ms and over. */
+    static constexpr int numBuckets = 16;
+
+    struct Snapshot
+    {
+        double sampleRate{ 0.0 };
+
+        juce::int64 numBlocks{ 0 };
+        juce::int64 numDeadlineMisses{ 0 };
+        juce::uint32 durations[numBuckets]{};
+
+        /** In milliseconds. */
+        double lastBlockMs{ 0.0 }, worstBlockMs{ 0.0 };
+
+        /** Time taken over the time the block plays for. */
+        double lastLoad{ 0.0 }, peakLoad{ 0.0 }, totalLoad{ 0.0 };
+
+        int activeVoices{ 0 }, peakActiveVoices{ 0 };
+
+        /** Parameter changes that arrived between two blocks. */
+        int parameterChanges{ 0 }, peakParameterChanges{ 0 };
+
+        double getAverageLoad() const { return numBlocks > 0 ? totalLoad / (double) numBlocks : 0.0; }
+
+        /** Every figure and the whole histogram, one per line. */
+        juce::String toString() const;
+        bool writeTo(const juce::File& file) const;
+    };
+
+    static juce::String getBucketName(int bucket);
+
+    /** Where dumped snapshots go by default. */
+    static juce::File getDumpDirectory();
+
+    /** Starts over for a new rate. Not while the audio thread is in processBlock. */
+    void prepare(double sampleRate);
+
+    /** Starts over at the next block. Any thread. */
+    void reset() noexcept { mResetRequested.store(true, std::memory_order_relaxed); }
+
+    /** Audio thread, once per block. */
+    void blockFinished(juce::int64 startTicks, int numSamples, int activeVoices, int parameterChanges) noexcept;
+
+    /** The latest published snapshot. Wait-free, one reader thread at a time. */
+    Snapshot getSnapshot() noexcept;
+
+private:
+    // slots of the triple buffer: the writer fills mSlots[mBack], the reader holds
+    // mSlots[mFront], the last one sits in the middle and is swapped by both
+    Snapshot mSlots[3];
+    static constexpr int freshBit = 4;
+    std::atomic<int> mMiddle{ 1 };
+    int mBack{ 0 };
+    int mFront{ 2 };
+
+    // audio thread only
+    Snapshot mCurrent;
+    double mTicksPerSecond{ (double) juce::Time::getHighResolutionTicksPerSecond() };
+
+    std::atomic<bool> mResetRequested{ false };
+};
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    TelemetryComponent.cpp
+    Created: 22 Feb 2025 1:37:08pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "TelemetryComponent.h"
+
+//==============================================================================
+TelemetryComponent::TelemetryComponent(YellowRoseAudioProcessor& p) : audioProcessor(p)
+{
+    mDumpButton.setTooltip("Write the telemetry to a text file");
+    mDumpButton.onClick = [this]() { dump(); };
+    addAndMakeVisible(mDumpButton);
+
+    mResetButton.setTooltip("Start counting again");
+    mResetButton.onClick = [this]() { audioProcessor.resetTelemetry(); };
+    addAndMakeVisible(mResetButton);
+
+    startTimerHz(10);
+}
+
+TelemetryComponent::~TelemetryComponent()
+{
+    stopTimer();
+}
+
+void TelemetryComponent::paint (juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::grey.darker(0.5f));
+
+    auto& s = mSnapshot;
+
+    g.setColour(s.numDeadlineMisses > 0 ? juce::Colours::orange : juce::Colours::white);
+    g.setFont(juce::FontOptions(12.0f));
+
+    auto lineHeight = mTextArea.getHeight() / 2;
+
+    g.drawText("Load " + juce::String(s.lastLoad * 100.0, 0) + "%, peak " + juce::String(s.peakLoad * 100.0, 0)
+                   + "%   Worst " + juce::String(s.worstBlockMs, 2) + " ms   Misses " + juce::String(s.numDeadlineMisses),
+               mTextArea.withHeight(lineHeight), juce::Justification::centredLeft, true);
+
+    g.setColour(juce::Colours::white);
+    g.drawText("Voices " + juce::String(s.activeVoices) + ", peak " + juce::String(s.peakActiveVoices)
+                   + "   Parameter changes " + juce::String(s.parameterChanges) + ", peak " + juce::String(s.peakParameterChanges),
+               mTextArea.withTrimmedTop(lineHeight), juce::Justification::centredLeft, true);
+
+    // bar heights on a log scale, so the rare slow blocks still show next to the usual ones
+    juce::uint32 mostBlocks = 1;
+
+    for (auto count : s.durations)
+        mostBlocks = juce::jmax(mostBlocks, count);
+
+    auto barWidth = (float) mHistogramArea.getWidth() / Telemetry::numBuckets;
+    auto scale = (float) mHistogramArea.getHeight() / std::log1p((float) mostBlocks);
+
+    g.setColour(juce::Colours::yellow);
+
+    for (int bucket = 0; bucket < Telemetry::numBuckets; ++bucket) {
+        auto height = std::log1p((float) s.durations[bucket]) * scale;
+
+        g.fillRect(juce::Rectangle<float>((float) mHistogramArea.getX() + bucket * barWidth, (float) mHistogramArea.getBottom() - height,
+                                          barWidth - 1.0f, height));
+    }
+}
+
+void TelemetryComponent::resized()
+{
+    auto bounds = getLocalBounds().reduced(4, 2);
+
+    mResetButton.setBounds(bounds.removeFromRight(50));
+    bounds.removeFromRight(4);
+    mDumpButton.setBounds(bounds.removeFromRight(50));
+    bounds.removeFromRight(8);
+    mHistogramArea = bounds.removeFromRight(Telemetry::numBuckets * 6);
+    bounds.removeFromRight(8);
+    mTextArea = bounds;
+}
+
+void TelemetryComponent::timerCallback()
+{
+    mSnapshot = audioProcessor.getTelemetry();
+    repaint();
+}
+
+void TelemetryComponent::dump()
+{
+    auto name = "Telemetry " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S");
+    auto file = Telemetry::getDumpDirectory().getNonexistentChildFile(name, ".txt", false);
+
+    // the snapshot on screen, so the file matches what was seen
+    if (mSnapshot.writeTo(file))
+        file.revealToUser();
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    TelemetryComponent.h
+    Created: 22 Feb 2025 1:37:08pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/*
+    Shows the processor's telemetry a few times a second: the load, deadline misses,
+    voices and parameter changes, with the block durations as a small histogram.
+    Dump writes the whole snapshot to a text file for a bug report.
+*/
+class TelemetryComponent  : public juce::Component, private juce::Timer
+{
+public:
+    TelemetryComponent(YellowRoseAudioProcessor& p);
+    ~TelemetryComponent() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+    void dump();
+
+    Telemetry::Snapshot mSnapshot;
+    juce::Rectangle<int> mTextArea, mHistogramArea;
+
+    juce::TextButton mDumpButton{ "Dump" };
+    juce::TextButton mResetButton{ "Reset" };
+
+    YellowRoseAudioProcessor& audioProcessor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetryComponent)
+};
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    VoiceBank.cpp
+    Created: 5 Apr 2025 4:18:52pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "VoiceBank.h"
+
+namespace
+{
+    size_t getArrayBytes(size_t elementSize, int numElements, size_t alignment) noexcept
+    {
+        return (elementSize * (size_t) numElements + alignment - 1) / alignment * alignment;
+    }
+}
+
+void VoiceBank::prepare(int maxVoices)
+{
+    mCapacity = juce::jmax(0, maxVoices);
+
+    // one block, every array starting on a cache line of its own
+    size_t totalBytes = cacheLineSize;
+    forEachArray([&](auto*& array) { totalBytes += getArrayBytes(sizeof(*array), mCapacity, cacheLineSize); });
+
+    mStorage.calloc(totalBytes);
+    auto* next = juce::snapPointerToAlignment(mStorage.get(), cacheLineSize);
+
+    forEachArray([&](auto*& array) {
+        array = reinterpret_cast<std::remove_reference_t<decltype(array)>>(next);
+        next += getArrayBytes(sizeof(*array), mCapacity, cacheLineSize);
+    });
+}
+
+void VoiceBank::render(juce::SynthesiserVoice* const* voices, int numVoices,
+                       juce::AudioBuffer<float>& output, int startSample, int numSamples) noexcept
+{
+    int numLoaded = 0;
+
+    for (int i = 0; i < numVoices; ++i) {
+        // every voice of the synthesiser is one of ours, and the flag is only set by SampleVoice
+        auto* voice = static_cast<YellowRoseVoice*>(voices[i]);
+
+        if (voice->rendersInVoiceBank() && numLoaded < mCapacity && load(static_cast<SampleVoice&>(*voice), numLoaded))
+            ++numLoaded;
+        else
+            voice->renderNextBlock(output, startSample, numSamples);
+    }
+
+    renderLoaded(numLoaded, output, startSample, numSamples);
+
+    for (int slot = 0; slot < numLoaded; ++slot) {
+        store(slot);
+
+        // the rest of the span, from the chunk where the voice left the bank
+        auto framesDone = mFramesDone[slot];
+
+        if (framesDone < numSamples)
+            mVoices[slot]->renderNextBlock(output, startSample + framesDone, numSamples - framesDone);
+    }
+}
+
+bool VoiceBank::load(SampleVoice& voice, int slot) noexcept
+{
+    if (voice.getCurrentlyPlayingSound() == nullptr || voice.mIsWaitingForDecoder)
+        return false;
+
+    float envelopeStep;
+    auto envelopeFrames = voice.mEnvelope.getLinearFrames(envelopeStep);
+
+    if (envelopeFrames == 0)
+        return false;
+
+    mVoices[slot] = &voice;
+    mLeftSources[slot] = voice.mView.getChannel(0);
+    mRightSources[slot] = voice.mView.numChannels > 1 ? voice.mView.getChannel(1) : nullptr;
+    mModes[slot] = voice.mInterpolation;
+    mPositions[slot] = voice.mSourceSamplePosition;
+    mRatios[slot] = voice.mPitchRatio;
+    mSegmentEnds[slot] = voice.getSegmentEnd();
+    mGains[slot] = voice.mGain;
+    mEnvelopeLevels[slot] = voice.mEnvelope.getLevel();
+    mEnvelopeSteps[slot] = envelopeStep;
+    mEnvelopeFrames[slot] = envelopeFrames;
+    mFramesDone[slot] = 0;
+    return true;
+}
+
+void VoiceBank::store(int slot) noexcept
+{
+    if (mFramesDone[slot] == 0)
+        return;
+
+    auto& voice = *mVoices[slot];
+
+    voice.mSourceSamplePosition = mPositions[slot];
+    voice.mEnvelope.setRampLevel(mEnvelopeLevels[slot]);
+    voice.mLevel = mEnvelopeLevels[slot] * mGains[slot];
+    voice.mDisplayPosition.store(voice.getSamplePosition(), std::memory_order_relaxed);
+}
+
+void VoiceBank::renderLoaded(int numLoaded, juce::AudioBuffer<float>& output, int startSample, int numSamples) noexcept
+{
+    float* outL = output.getWritePointer(0, startSample);
+    float* outR = output.getNumChannels() > 1 ? output.getWritePointer(1, startSample) : nullptr;
+
+    alignas(32) float left[chunkSize];
+    alignas(32) float right[chunkSize];
+    alignas(32) float gains[chunkSize];
+
+    auto numLive = numLoaded;
+
+    for (int slot = 0; slot < numLoaded; ++slot)
+        mLiveSlots[slot] = slot;
+
+    for (int offset = 0; offset < numSamples && numLive > 0; offset += chunkSize) {
+        auto numThisTime = juce::jmin(chunkSize, numSamples - offset);
+
+        for (int i = 0; i < numLive;) {
+            auto slot = mLiveSlots[i];
+            auto position = mPositions[slot];
+            auto ratio = mRatios[slot];
+
+            // the chunk that reaches the end of the segment, and a bend in the envelope, are
+            // the voice's own to render. It takes over from here.
+            auto framesLeft = std::ceil((mSegmentEnds[slot] - position) / ratio);
+
+            if ((double) numThisTime >= framesLeft || numThisTime > mEnvelopeFrames[slot]) {
+                mFramesDone[slot] = offset;
+                mLiveSlots[i] = mLiveSlots[--numLive];
+                continue;
+            }
+
+            const auto* rightSource = mRightSources[slot];
+
+            Interpolator::process(mModes[slot], mLeftSources[slot], position, ratio, left, numThisTime);
+
+            if (rightSource != nullptr)
+                Interpolator::process(mModes[slot], rightSource, position, ratio, right, numThisTime);
+
+            // the envelope's own ramp, scaled by the voice's gain, as SampleVoice works it out
+            auto level = mEnvelopeLevels[slot];
+            auto step = mEnvelopeSteps[slot];
+            auto gain = mGains[slot];
+
+            for (int frame = 0; frame < numThisTime; ++frame)
+                gains[frame] = (level + step * (float) (frame + 1)) * gain;
+
+            const float* rightChannel = rightSource != nullptr ? right : left;
+
+            if (outR != nullptr) {
+                juce::FloatVectorOperations::addWithMultiply(outL + offset, left, gains, numThisTime);
+                juce::FloatVectorOperations::addWithMultiply(outR + offset, rightChannel, gains, numThisTime);
+            }
+            else {
+                juce::FloatVectorOperations::multiply(gains, 0.5f, numThisTime);
+                juce::FloatVectorOperations::addWithMultiply(outL + offset, left, gains, numThisTime);
+                juce::FloatVectorOperations::addWithMultiply(outL + offset, rightChannel, gains, numThisTime);
+            }
+
+            mPositions[slot] = position + numThisTime * ratio;
+            mEnvelopeLevels[slot] = level + step * (float) numThisTime;
+            mEnvelopeFrames[slot] -= numThisTime;
+            mFramesDone[slot] = offset + numThisTime;
+            ++i;
+        }
+    }
+}
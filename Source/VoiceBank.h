@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    VoiceBank.h
+    Created: 5 Apr 2025 4:18:52pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleVoice.h"
+
+//==============================================================================
+/*
+    Renders a group of SampleVoices in one loop over struct-of-arrays state,
+    instead of one renderNextBlock() call per voice.
+
+    At the start of a span each voice's position, pitch ratio, gain, envelope
+    ramp and source channels are copied into per-field arrays, each on cache lines
+    of its own. The span is then rendered a chunk at a time: for every chunk, one
+    pass over the arrays interpolates, ramps and mixes each voice still in the
+    bank. Nothing in that loop goes through the voice objects or a virtual call.
+
+    Only the steady part of a note is done here. A voice leaves the bank at the
+    last chunk of its segment, where its envelope stops being a straight line, or
+    while it's waiting for the decoder. What's left of the span it renders itself,
+    through renderNextBlock(). Voices that aren't SampleVoices always do.
+*/
+class VoiceBank
+{
+public:
+    static constexpr int chunkSize = SampleVoice::chunkSize;
+
+    VoiceBank() = default;
+
+    /** Allocates the arrays for up to maxVoices voices. Not on the audio thread. */
+    void prepare(int maxVoices);
+
+    /** Adds the voices to the buffer, like calling renderNextBlock() on each. */
+    void render(juce::SynthesiserVoice* const* voices, int numVoices,
+                juce::AudioBuffer<float>& output, int startSample, int numSamples) noexcept;
+
+private:
+    static constexpr size_t cacheLineSize = 64;
+
+    /** Copies the voice into the slot. Returns false if it can't start in the bank. */
+    bool load(SampleVoice& voice, int slot) noexcept;
+
+    /** Hands the slot's state back to its voice. */
+    void store(int slot) noexcept;
+
+    void renderLoaded(int numLoaded, juce::AudioBuffer<float>& output, int startSample, int numSamples) noexcept;
+
+    template <typename Visitor>
+    void forEachArray(Visitor&& visit)
+    {
+        visit(mPositions);
+        visit(mRatios);
+        visit(mSegmentEnds);
+        visit(mGains);
+        visit(mEnvelopeLevels);
+        visit(mEnvelopeSteps);
+        visit(mEnvelopeFrames);
+        visit(mFramesDone);
+        visit(mLiveSlots);
+        visit(mLeftSources);
+        visit(mRightSources);
+        visit(mModes);
+        visit(mVoices);
+    }
+
+    juce::HeapBlock<char> mStorage;
+    int mCapacity{ 0 };
+
+    // per slot, where the voice reads from and how fast
+    double* mPositions{ nullptr };
+    double* mRatios{ nullptr };
+    double* mSegmentEnds{ nullptr };
+
+    // per slot, the gain is the voice's velocity gain, the envelope a ramp of level + step * frame
+    float* mGains{ nullptr };
+    float* mEnvelopeLevels{ nullptr };
+    float* mEnvelopeSteps{ nullptr };
+    int* mEnvelopeFrames{ nullptr };
+
+    // per slot, how far into the span the bank got with the voice
+    int* mFramesDone{ nullptr };
+
+    // the slots still being rendered, in no particular order
+    int* mLiveSlots{ nullptr };
+
+    const float** mLeftSources{ nullptr };
+    const float** mRightSources{ nullptr };
+    InterpolationMode* mModes{ nullptr };
+    SampleVoice** mVoices{ nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceBank)
+};
@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    VoiceFilter.cpp
+    Created: 15 Mar 2025 10:37:58am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "VoiceFilter.h"
+
+namespace
+{
+    constexpr int numLanes = VoiceFilter::numLanes;
+
+    struct Coefficients
+    {
+        float a1, a2, a3;
+    };
+
+    Coefficients getCoefficients(double cutoffHz, double sampleRate, float k) noexcept
+    {
+        // kept clear of Nyquist, where the prewarped gain goes to infinity
+        auto g = (float) std::tan(juce::MathConstants<double>::pi * juce::jlimit(10.0, sampleRate * 0.45, cutoffHz) / sampleRate);
+        auto a1 = 1.0f / (1.0f + g * (g + k));
+        auto a2 = g * a1;
+
+        return { a1, a2, g * a2 };
+    }
+}
+
+//==============================================================================
+void VoiceFilter::process(juce::SynthesiserVoice* const* voices, int numVoices,
+                          juce::AudioBuffer<float>& output, int startSample, int numSamples) const noexcept
+{
+    for (int first = 0; first < numVoices; first += voicesPerGroup)
+        processGroup(voices + first, juce::jmin(voicesPerGroup, numVoices - first), output, startSample, numSamples);
+}
+
+void VoiceFilter::processGroup(juce::SynthesiserVoice* const* voices, int numVoices,
+                               juce::AudioBuffer<float>& output, int startSample, int numSamples) const noexcept
+{
+    const auto settings = mSettings;
+    const auto k = 1.0f / juce::jmax(0.1f, settings.resonance);
+
+    // the outputs are mixed with these, so every type runs the same code
+    const auto low = settings.type == FilterType::lowPass ? 1.0f : 0.0f;
+    const auto band = settings.type == FilterType::bandPass ? 1.0f : 0.0f;
+    const auto high = settings.type == FilterType::highPass ? 1.0f : 0.0f;
+
+    YellowRoseVoice* filterVoices[voicesPerGroup]{};
+
+    for (int v = 0; v < numVoices; ++v)
+        filterVoices[v] = static_cast<YellowRoseVoice*>(voices[v]);
+
+    // lane = voice * 2 + channel
+    alignas(32) float dry[numLanes][sliceSize];
+    alignas(32) float frames[sliceSize * numLanes];
+    alignas(32) float ic1[numLanes]{}, ic2[numLanes]{};
+    alignas(32) float a1[numLanes]{}, a2[numLanes]{}, a3[numLanes]{};
+    alignas(32) float a1Step[numLanes]{}, a2Step[numLanes]{}, a3Step[numLanes]{};
+    alignas(32) float envelope[sliceSize];
+
+    for (int offset = 0; offset < numSamples; offset += sliceSize) {
+        const auto numThisTime = juce::jmin(sliceSize, numSamples - offset);
+
+        for (int lane = 0; lane < numLanes; ++lane)
+            juce::FloatVectorOperations::clear(dry[lane], numThisTime);
+
+        // gather: render dry, and pick up each voice's state and where its cutoff is heading
+        for (int v = 0; v < numVoices; ++v) {
+            auto* voice = filterVoices[v];
+            auto& state = voice->getFilterState();
+
+            float* channels[] = { dry[v * 2], dry[v * 2 + 1] };
+            juce::AudioBuffer<float> slice(channels, 2, numThisTime);
+            voice->renderNextBlock(slice, 0, numThisTime);
+
+            state.envelope.getNextBlock(envelope, numThisTime);
+
+            auto octaves = settings.keyTracking * (state.note - 60) / 12.0f + settings.envelopeOctaves * envelope[numThisTime - 1];
+            auto target = getCoefficients(settings.cutoffHz * std::exp2(octaves), mSampleRate, k);
+
+            if (!state.hasCoefficients) {
+                state.a1 = target.a1;
+                state.a2 = target.a2;
+                state.a3 = target.a3;
+                state.hasCoefficients = true;
+            }
+
+            for (int ch = 0; ch < 2; ++ch) {
+                auto lane = v * 2 + ch;
+
+                ic1[lane] = state.ic1[ch];
+                ic2[lane] = state.ic2[ch];
+                a1[lane] = state.a1;
+                a2[lane] = state.a2;
+                a3[lane] = state.a3;
+                a1Step[lane] = (target.a1 - state.a1) / (float) numThisTime;
+                a2Step[lane] = (target.a2 - state.a2) / (float) numThisTime;
+                a3Step[lane] = (target.a3 - state.a3) / (float) numThisTime;
+            }
+
+            state.a1 = target.a1;
+            state.a2 = target.a2;
+            state.a3 = target.a3;
+        }
+
+        for (int i = 0; i < numThisTime; ++i)
+            for (int lane = 0; lane < numLanes; ++lane)
+                frames[i * numLanes + lane] = dry[lane][i];
+
+        // every lane at once, this is the part that vectorises. Lanes without a voice
+        // filter silence with zero coefficients and stay silent
+        for (int i = 0; i < numThisTime; ++i) {
+            auto* frame = frames + i * numLanes;
+
+            for (int lane = 0; lane < numLanes; ++lane) {
+                a1[lane] += a1Step[lane];
+                a2[lane] += a2Step[lane];
+                a3[lane] += a3Step[lane];
+
+                auto v0 = frame[lane];
+                auto v3 = v0 - ic2[lane];
+                auto v1 = a1[lane] * ic1[lane] + a2[lane] * v3;
+                auto v2 = ic2[lane] + a2[lane] * ic1[lane] + a3[lane] * v3;
+
+                ic1[lane] = 2.0f * v1 - ic1[lane];
+                ic2[lane] = 2.0f * v2 - ic2[lane];
+
+                frame[lane] = low * v2 + band * v1 + high * (v0 - k * v1 - v2);
+            }
+        }
+
+        for (int i = 0; i < numThisTime; ++i)
+            for (int lane = 0; lane < numLanes; ++lane)
+                dry[lane][i] = frames[i * numLanes + lane];
+
+        // scatter: the states go back to their voices, the sound to the output
+        for (int v = 0; v < numVoices; ++v) {
+            auto& state = filterVoices[v]->getFilterState();
+
+            for (int ch = 0; ch < 2; ++ch) {
+                state.ic1[ch] = ic1[v * 2 + ch];
+                state.ic2[ch] = ic2[v * 2 + ch];
+            }
+        }
+
+        if (output.getNumChannels() > 1) {
+            for (int v = 0; v < numVoices; ++v) {
+                output.addFrom(0, startSample + offset, dry[v * 2], numThisTime);
+                output.addFrom(1, startSample + offset, dry[v * 2 + 1], numThisTime);
+            }
+        }
+        else {
+            // the voices only mix to mono themselves when they're given one channel
+            for (int v = 0; v < numVoices; ++v) {
+                output.addFrom(0, startSample + offset, dry[v * 2], numThisTime, 0.5f);
+                output.addFrom(0, startSample + offset, dry[v * 2 + 1], numThisTime, 0.5f);
+            }
+        }
+    }
+}
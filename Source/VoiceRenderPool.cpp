@@ -0,0 +1,298 @@
+/*
+  ==============================================================================
+
+    VoiceRenderPool.cpp
+    Created: 14 Dec 2024 2:37:05pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "VoiceRenderPool.h"
+#include "RealtimeGuard.h"
+#include "RealtimeSemaphore.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // tells the core we're spinning, so the other hyperthread gets the pipeline
+    void pauseCpu() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && JUCE_MSVC
+        __yield();
+       #elif JUCE_ARM
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+}
+
+// a task is exactly one filter group, so no lanes go spare
+static_assert(VoiceRenderPool::voicesPerTask == VoiceFilter::voicesPerGroup, "tasks and filter groups should match");
+
+class VoiceRenderPool::Worker  : public juce::Thread
+{
+public:
+    Worker(VoiceRenderPool& pool, int index) : juce::Thread("YellowRose voice worker " + juce::String(index)), mPool(pool)
+    {
+    }
+
+    void wake() noexcept { mWake.signal(); }
+
+    void start()
+    {
+        if (!startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(9)))
+            startThread(juce::Thread::Priority::highest);
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        wake();
+        stopThread(1000);
+    }
+
+private:
+    void run() override
+    {
+        auto seen = mPool.mGeneration.load(std::memory_order_acquire);
+
+        while (!threadShouldExit()) {
+            mWake.wait(100);
+
+            auto generation = mPool.mGeneration.load(std::memory_order_acquire);
+
+            if (generation == seen)
+                continue;
+
+            seen = generation;
+
+            const RealtimeGuard::ScopedRealtimeThread realtimeThread;
+            mPool.workerWoke();
+            mPool.runTasks();
+        }
+    }
+
+    VoiceRenderPool& mPool;
+    RealtimeSemaphore mWake;
+};
+
+//==============================================================================
+VoiceRenderPool::~VoiceRenderPool()
+{
+    release();
+}
+
+void VoiceRenderPool::prepare(int numWorkers, int maxBlockSize, int maxVoices)
+{
+    release();
+
+    const NonRealtimeLock::ScopedLockType sl(mWorkersLock);
+
+    mMaxTasks = juce::jmin(maxTasks, (maxVoices + voicesPerTask - 1) / voicesPerTask);
+    mMaxBlockSize = maxBlockSize;
+    mTaskBuffers.setSize(mMaxTasks * 2, maxBlockSize);
+
+    // the tasks write through these, so several threads never touch the buffer object itself
+    mTaskChannels.assign(mTaskBuffers.getArrayOfWritePointers(), mTaskBuffers.getArrayOfWritePointers() + mMaxTasks * 2);
+
+    // started by setWorkersRunning(), the array itself never changes while the audio thread renders
+    for (int i = 0; i < numWorkers; ++i)
+        mWorkers.add(new Worker(*this, i));
+}
+
+void VoiceRenderPool::setWorkersRunning(bool shouldRun)
+{
+    const NonRealtimeLock::ScopedLockType sl(mWorkersLock);
+
+    if (shouldRun == mWorkersRunning.load() || mWorkers.isEmpty())
+        return;
+
+    if (shouldRun) {
+        for (auto* worker : mWorkers)
+            worker->start();
+
+        mWorkersRunning = true;
+    }
+    else {
+        // blocks rendering now leave the pool alone, one that's in already is finished
+        // first: a worker only looks at exiting between blocks
+        mWorkersRunning = false;
+
+        for (auto* worker : mWorkers)
+            worker->stop();
+    }
+}
+
+void VoiceRenderPool::release()
+{
+    setWorkersRunning(false);
+
+    const NonRealtimeLock::ScopedLockType sl(mWorkersLock);
+    mWorkers.clear();
+    mMaxTasks = 0;
+}
+
+bool VoiceRenderPool::render(juce::SynthesiserVoice* const* voices, int numVoices, const VoiceFilter* filter,
+                             juce::AudioBuffer<float>& output, int startSample, int numSamples)
+{
+    auto numTasks = (numVoices + voicesPerTask - 1) / voicesPerTask;
+
+    if (!mWorkersRunning.load(std::memory_order_relaxed) || numTasks > mMaxTasks
+        || numSamples > mMaxBlockSize || numSamples <= 0)
+        return false;
+
+    mVoices = voices;
+    mFilter = filter;
+    mNumVoices = numVoices;
+    mNumChannels = juce::jmin(2, output.getNumChannels());
+    mNumSamples = numSamples;
+
+    for (int ch = 0; ch < 2; ++ch)
+        mOutputChannels[(size_t) ch] = ch < mNumChannels ? output.getWritePointer(ch, startSample) : nullptr;
+
+    mTasksDone.store(0, std::memory_order_relaxed);
+    mTaskTicks.store(0, std::memory_order_relaxed);
+
+    auto start = juce::Time::getHighResolutionTicks();
+    mPublishTicks.store(start, std::memory_order_relaxed);
+
+    auto generation = mGeneration.load(std::memory_order_relaxed) + 1;
+
+    // everything above is published by this store, see runTasks()
+    mNextTask.store(((juce::uint64) (generation & 0xffffff) << 40) | ((juce::uint64) numTasks << 32), std::memory_order_release);
+    mGeneration.store(generation, std::memory_order_release);
+
+    // a system call at most, only for workers that are asleep
+    for (auto* worker : mWorkers)
+        worker->wake();
+
+    // every task no worker has picked up yet is rendered here, however many workers woke
+    runTasks();
+
+    // the ones still missing are being rendered by workers and can't be taken back without
+    // playing their voices twice. Spin gently at first, then hand the core over in case a
+    // worker got preempted and is waiting for it.
+    for (int spins = 0; mTasksDone.load(std::memory_order_acquire) < numTasks; ++spins) {
+        if (spins < maxPauseSpins)
+            pauseCpu();
+        else
+            juce::Thread::yield();
+    }
+
+    auto wallTicks = juce::Time::getHighResolutionTicks() - start;
+    auto bucket = juce::jlimit(0, numBlockSizeBuckets - 1, juce::findHighestSetBit((juce::uint32) numSamples) - 4);
+
+    mWallTicks[bucket].fetch_add(wallTicks, std::memory_order_relaxed);
+    mWorkTicks[bucket].fetch_add(mTaskTicks.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    mNumBlocks[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    // in task order, so the sum comes out the same every time. The first one is in already.
+    for (int task = 1; task < numTasks; ++task)
+        for (int ch = 0; ch < mNumChannels; ++ch)
+            output.addFrom(ch, startSample, mTaskChannels[(size_t) (task * 2 + ch)], numSamples);
+
+    return true;
+}
+
+void VoiceRenderPool::runTasks() noexcept
+{
+    for (;;) {
+        // the value comes from the block it was reset for, and acquiring it makes that
+        // block's state visible. A worker still running from the last block can't pick
+        // up a stale index, and the audio thread only moves on once every task is done.
+        auto next = mNextTask.fetch_add(1, std::memory_order_acq_rel);
+        auto task = (int) (next & 0xffffffff);
+        auto numTasks = (int) ((next >> 32) & 0xff);
+
+        if (task >= numTasks)
+            break;
+
+        runTask(task);
+        mTasksDone.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void VoiceRenderPool::runTask(int task) noexcept
+{
+    auto start = juce::Time::getHighResolutionTicks();
+
+    // refers to the output for the first task, to the task's part of mTaskBuffers for the
+    // others, no allocation for two channels
+    float* channels[] = { mTaskChannels[(size_t) task * 2], mTaskChannels[(size_t) task * 2 + 1] };
+
+    if (task == 0)
+        std::copy(mOutputChannels.begin(), mOutputChannels.end(), channels);
+
+    juce::AudioBuffer<float> buffer(channels, mNumChannels, mNumSamples);
+
+    if (task > 0)
+        buffer.clear();
+
+    auto first = task * voicesPerTask;
+    auto end = juce::jmin(mNumVoices, first + voicesPerTask);
+
+    if (mFilter != nullptr) {
+        mFilter->process(mVoices + first, end - first, buffer, 0, mNumSamples);
+    }
+    else {
+        for (int i = first; i < end; ++i)
+            mVoices[i]->renderNextBlock(buffer, 0, mNumSamples);
+    }
+
+    mTaskTicks.fetch_add(juce::Time::getHighResolutionTicks() - start, std::memory_order_relaxed);
+}
+
+void VoiceRenderPool::workerWoke() noexcept
+{
+    auto latency = juce::Time::getHighResolutionTicks() - mPublishTicks.load(std::memory_order_relaxed);
+
+    mWakeUpTicksTotal.fetch_add(latency, std::memory_order_relaxed);
+    mNumWakeUps.fetch_add(1, std::memory_order_relaxed);
+
+    auto previousMax = mWakeUpTicksMax.load(std::memory_order_relaxed);
+
+    while (latency > previousMax && !mWakeUpTicksMax.compare_exchange_weak(previousMax, latency, std::memory_order_relaxed))
+        ;
+}
+
+//==============================================================================
+VoiceRenderPool::Stats VoiceRenderPool::getStats() const
+{
+    auto toMs = [](juce::int64 ticks) { return juce::Time::highResolutionTicksToSeconds(ticks) * 1000.0; };
+
+    Stats stats;
+    auto numWakeUps = mNumWakeUps.load();
+
+    if (numWakeUps > 0)
+        stats.averageWakeUpMs = toMs(mWakeUpTicksTotal.load()) / numWakeUps;
+
+    stats.maxWakeUpMs = toMs(mWakeUpTicksMax.load());
+
+    for (int i = 0; i < numBlockSizeBuckets; ++i) {
+        auto wallTicks = mWallTicks[i].load();
+        stats.numBlocks[i] = mNumBlocks[i].load();
+
+        if (wallTicks > 0)
+            stats.speedup[i] = (double) mWorkTicks[i].load() / (double) wallTicks;
+    }
+
+    return stats;
+}
+
+void VoiceRenderPool::resetStats()
+{
+    mWakeUpTicksTotal = 0;
+    mWakeUpTicksMax = 0;
+    mNumWakeUps = 0;
+
+    for (int i = 0; i < numBlockSizeBuckets; ++i) {
+        mWallTicks[i] = 0;
+        mWorkTicks[i] = 0;
+        mNumBlocks[i] = 0;
+    }
+}
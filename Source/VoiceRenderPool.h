@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    VoiceRenderPool.h
+    Created: 14 Dec 2024 2:37:05pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "VoiceFilter.h"
+#include "RealtimeGuard.h"
+
+//==============================================================================
+/*
+    Spreads the active voices of a block over a few real-time worker threads.
+
+    The voices are cut into tasks of voicesPerTask consecutive voices. The audio
+    thread and the workers take tasks from an atomic counter until none are left.
+    The first task renders straight into the output, which nothing else touches
+    until every task is done, and the others into buffers of their own. The audio
+    thread then adds those to the output in task order. The mix is the same
+    whichever thread ran which task.
+
+    The audio thread never waits for a worker to wake up: if none do, it simply
+    runs every task itself. Waking them is lock-free, through a RealtimeSemaphore
+    per worker, and the workers only run while they're switched on, which the
+    plugin does with its MULTICORE parameter.
+
+    With a filter given, each task runs its voices through it as one filter group.
+*/
+class VoiceRenderPool
+{
+public:
+    static constexpr int voicesPerTask = 4;
+    static constexpr int maxTasks = 255;
+    static constexpr int numBlockSizeBuckets = 9; // 16 to 4096 frames
+
+    // how long the audio thread waits for the last tasks with pause instructions before it yields
+    static constexpr int maxPauseSpins = 2000;
+
+    struct Stats
+    {
+        /** Time from the audio thread publishing a block to a worker starting on it. */
+        double averageWakeUpMs{ 0.0 }, maxWakeUpMs{ 0.0 };
+
+        /** Time the tasks took added up, over the time the block took. Indexed by
+            log2(block size) - 4, zero for block sizes that haven't been seen.
+        */
+        double speedup[numBlockSizeBuckets]{};
+        int numBlocks[numBlockSizeBuckets]{};
+    };
+
+    VoiceRenderPool() = default;
+    ~VoiceRenderPool();
+
+    /** Creates the workers, stopped, and sizes the task buffers. Not on the audio thread,
+        and not while it renders.
+    */
+    void prepare(int numWorkers, int maxBlockSize, int maxVoices);
+
+    /** Starts or stops the workers. Not on the audio thread, but it may be rendering. */
+    void setWorkersRunning(bool shouldRun);
+
+    /** Stops and deletes the workers. Not on the audio thread. */
+    void release();
+
+    /** Renders the voices, through the filter if there is one, and adds them to the
+        output. Returns false without doing anything if the workers aren't running or
+        the pool isn't prepared for this many voices or frames.
+    */
+    bool render(juce::SynthesiserVoice* const* voices, int numVoices, const VoiceFilter* filter,
+                juce::AudioBuffer<float>& output, int startSample, int numSamples);
+
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    class Worker;
+
+    void runTasks() noexcept;
+    void runTask(int task) noexcept;
+    void workerWoke() noexcept;
+
+    juce::OwnedArray<Worker> mWorkers;
+    NonRealtimeLock mWorkersLock;
+    std::atomic<bool> mWorkersRunning{ false };
+    juce::AudioBuffer<float> mTaskBuffers; // two channels per task, the first task's go unused
+    std::vector<float*> mTaskChannels;
+    int mMaxTasks{ 0 };
+    int mMaxBlockSize{ 0 };
+
+    // the block being rendered, written by the audio thread before mNextTask is reset
+    juce::SynthesiserVoice* const* mVoices{ nullptr };
+    const VoiceFilter* mFilter{ nullptr };
+    std::array<float*, 2> mOutputChannels{}; // from the block's first sample
+    int mNumVoices{ 0 };
+    int mNumChannels{ 0 };
+    int mNumSamples{ 0 };
+
+    // generation in the top 24 bits, the number of tasks in the next 8 and the next
+    // task to hand out in the low 32, so a task index always comes with its block
+    std::atomic<juce::uint64> mNextTask{ 0 };
+    std::atomic<int> mTasksDone{ 0 };
+    std::atomic<juce::uint32> mGeneration{ 0 };
+    std::atomic<juce::int64> mPublishTicks{ 0 };
+    std::atomic<juce::int64> mTaskTicks{ 0 };
+
+    // stats, in high resolution ticks
+    std::atomic<juce::int64> mWakeUpTicksTotal{ 0 }, mWakeUpTicksMax{ 0 };
+    std::atomic<int> mNumWakeUps{ 0 };
+    std::atomic<juce::int64> mWallTicks[numBlockSizeBuckets]{}, mWorkTicks[numBlockSizeBuckets]{};
+    std::atomic<int> mNumBlocks[numBlockSizeBuckets]{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceRenderPool)
+};
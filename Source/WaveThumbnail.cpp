@@ -10,61 +10,236 @@
 
 #include <JuceHeader.h>
 #include "WaveThumbnail.h"
+#include "StreamingVoice.h"
+#include "SampleVoice.h"
 
 //==============================================================================
 WaveThumbnail::WaveThumbnail(YellowRoseAudioProcessor& p) : audioProcessor (p)
 {
-    // In your constructor, you should add any child components, and
-    // initialise any special settings that your component needs.
+    // painted whole, so the tiles can be opaque
+    setOpaque(true);
 
+    mVoicePositions.assign(YellowRoseAudioProcessor::maxPolyphony + YellowRoseAudioProcessor::numStreamingVoices, -1.0f);
+    mNewVoicePositions = mVoicePositions;
+
+    audioProcessor.addChangeListener(this);
+    changeListenerCallback(&audioProcessor);
+    startTimerHz(timerHz);
 }
 
 WaveThumbnail::~WaveThumbnail()
 {
+    stopTimer();
+    audioProcessor.removeChangeListener(this);
 }
 
 void WaveThumbnail::paint (juce::Graphics& g)
 {
     g.fillAll(juce::Colours::grey.darker());
 
-    auto waveform = audioProcessor.getWaveForm();
+    if (mPeaks != nullptr && mPeaks->getNumFrames() > 0 && getWidth() > 0) {
+        paintWaveform(g);
+        paintOverlays(g);
+
+        g.setColour(juce::Colours::white);
+        g.setFont(juce::FontOptions(14.0f));
 
-    if (waveform.getNumSamples() > 0) {
-        juce::Path p;
-        mAudioPoints.clear();
+        auto textBounds = getLocalBounds().reduced(10, 10);
 
-        auto waveform = audioProcessor.getWaveForm();
-        auto ratio = waveform.getNumSamples() / getWidth();
-        auto buffer = waveform.getReadPointer(0);
+        g.drawFittedText(mName, textBounds, juce::Justification::topRight, 1);
 
-        //scale audio on x axis
-        for (int sample = 0; sample < waveform.getNumSamples(); sample += ratio) {
-            mAudioPoints.push_back(buffer[sample]);
+        if (mSampleChanged) {
+            g.setColour(juce::Colours::orange);
+            g.drawFittedText("This sample has changed since the session was saved", textBounds, juce::Justification::topLeft, 1);
         }
+    }
+    else {
+        g.setColour(juce::Colours::white);
+        g.setFont(20.0f);
+        g.drawFittedText("Drag and drop audio file to load", getLocalBounds(), juce::Justification::centred, 1);
+    }
+}
 
-        g.setColour(juce::Colours::yellow);
-        p.startNewSubPath(0, getHeight() / 2);
+void WaveThumbnail::paintWaveform(juce::Graphics& g)
+{
+    auto framesPerPixel = mVisibleRange.getLength() / getWidth();
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (framesPerPixel != mTileFramesPerPixel || getHeight() != mTileHeight || scale != mTileScale) {
+        clearTiles();
+        mTileFramesPerPixel = framesPerPixel;
+        mTileHeight = getHeight();
+        mTileScale = scale;
+    }
 
-        //scale audio on y axis
-        for (int sample = 0; sample < mAudioPoints.size(); ++sample) {
-            auto point = juce::jmap<float>(mAudioPoints[sample], -1.0f, 1.0f, getHeight(), 0);
-            p.lineTo(sample, point);
+    // the view starts on a whole column, so the tiles always land on whole pixels
+    auto firstColumn = (juce::int64) std::floor(mVisibleRange.getStart() / framesPerPixel);
+    auto firstTile = firstColumn / tileWidth;
+    auto lastTile = (firstColumn + getWidth() - 1) / tileWidth;
+
+    for (auto index = firstTile; index <= lastTile; ++index) {
+        auto x = (float) (index * tileWidth - firstColumn);
+        g.drawImageTransformed(getTile(index, framesPerPixel, scale),
+                               juce::AffineTransform::scale(1.0f / scale).translated(x, 0.0f));
+    }
+}
+
+void WaveThumbnail::paintOverlays(juce::Graphics& g)
+{
+    auto totalFrames = (double) mPeaks->getNumFrames();
+    auto height = (float) getHeight();
+
+    if (mLoopSettings.mode != LoopMode::off && mLoopSettings.end > mLoopSettings.start) {
+        auto left = frameToX(mLoopSettings.start * totalFrames);
+        auto right = frameToX(mLoopSettings.end * totalFrames);
+
+        g.setColour(juce::Colours::white.withAlpha(0.15f));
+        g.fillRect(juce::Rectangle<float>(left, 0.0f, right - left, height));
+        g.setColour(juce::Colours::white.withAlpha(0.6f));
+        g.drawVerticalLine(juce::roundToInt(left), 0.0f, height);
+        g.drawVerticalLine(juce::roundToInt(right), 0.0f, height);
+    }
+
+    g.setColour(juce::Colours::white);
+
+    for (auto position : mVoicePositions) {
+        if (position >= 0.0f)
+            g.drawVerticalLine(juce::roundToInt(frameToX(position * totalFrames)), 0.0f, height);
+    }
+}
+
+const juce::Image& WaveThumbnail::getTile(juce::int64 index, double framesPerPixel, float scale)
+{
+    ++mTileCounter;
+
+    for (auto& tile : mTiles) {
+        if (tile.index == index) {
+            tile.lastUsed = mTileCounter;
+            return tile.image;
         }
+    }
 
-        g.strokePath(p, juce::PathStrokeType(2));
+    if ((int) mTiles.size() >= maxTiles) {
+        auto oldest = std::min_element(mTiles.begin(), mTiles.end(), [](const Tile& a, const Tile& b) {
+            return a.lastUsed < b.lastUsed;
+        });
 
-        g.setColour(juce::Colours::white);
-        g.setFont(juce::FontOptions(14.0f));
+        mTiles.erase(oldest);
+    }
 
-        auto textBounds = getLocalBounds().reduced(10, 10);
+    mTiles.push_back({ index, renderTile(index, framesPerPixel, scale), mTileCounter });
+    return mTiles.back().image;
+}
+
+juce::Image WaveThumbnail::renderTile(juce::int64 index, double framesPerPixel, float scale) const
+{
+    juce::Image image(juce::Image::RGB, juce::roundToInt(tileWidth * scale), juce::roundToInt(getHeight() * scale), false);
+    juce::Graphics g(image);
+    g.addTransform(juce::AffineTransform::scale(scale));
+    g.fillAll(juce::Colours::grey.darker());
+
+    // only the in-memory part of the sample is used, and never copied
+    auto view = mData != nullptr ? mData->getView() : SampleView();
+
+    auto height = (float) getHeight();
+    auto totalFrames = (double) mPeaks->getNumFrames();
+
+    juce::RectangleList<float> peakColumns, rmsColumns;
+    peakColumns.ensureStorageAllocated(tileWidth);
+    rmsColumns.ensureStorageAllocated(tileWidth);
+
+    for (int x = 0; x < tileWidth; ++x) {
+        auto start = (double) (index * tileWidth + x) * framesPerPixel;
 
-        g.drawFittedText(mFileName, textBounds, juce::Justification::topRight, 1);
+        if (start >= totalFrames)
+            break;
+
+        auto peak = getPeakForRange(view, start, start + framesPerPixel);
+
+        auto top = juce::jmap(peak.max, -1.0f, 1.0f, height, 0.0f);
+        auto bottom = juce::jmap(peak.min, -1.0f, 1.0f, height, 0.0f);
+        peakColumns.addWithoutMerging({ (float) x, top, 1.0f, juce::jmax(1.0f, bottom - top) });
+
+        auto rmsHeight = juce::jmin(peak.rms, 1.0f) * height * 0.5f;
+        rmsColumns.addWithoutMerging({ (float) x, height * 0.5f - rmsHeight, 1.0f, rmsHeight * 2.0f });
     }
-    else {
-        g.setColour(juce::Colours::white);
-        g.setFont(20.0f);
-        g.drawFittedText("Drag and drop audio file to load", getLocalBounds(), juce::Justification::centred, 1);
+
+    g.setColour(juce::Colours::yellow);
+    g.fillRectList(peakColumns);
+    g.setColour(juce::Colours::orange);
+    g.fillRectList(rmsColumns);
+
+    return image;
+}
+
+void WaveThumbnail::clearTiles()
+{
+    mTiles.clear();
+}
+
+void WaveThumbnail::clearTilesBetween(double startFrame, double endFrame)
+{
+    auto framesPerTile = tileWidth * mTileFramesPerPixel;
+
+    if (framesPerTile <= 0.0)
+        return;
+
+    auto first = (juce::int64) std::floor(startFrame / framesPerTile);
+    auto last = (juce::int64) std::floor(endFrame / framesPerTile);
+
+    mTiles.erase(std::remove_if(mTiles.begin(), mTiles.end(), [first, last](const Tile& tile) {
+        return tile.index >= first && tile.index <= last;
+    }), mTiles.end());
+}
+
+void WaveThumbnail::updatePartialPeaks()
+{
+    auto view = mData->getView();
+    auto start = (int) mPartialPeaks->getNumFrames();
+    auto numFramesReady = view.getNumFramesReady();
+
+    if (numFramesReady <= start)
+        return;
+
+    const float* channels[] = { view.getChannel(0) + start, view.getChannel(1) + start };
+    mPartialPeaks->addFrames(channels, numFramesReady - start);
+    mPeaks = mPartialPeaks->snapshot(view.numFrames);
+
+    // the last bin of the previous snapshot was only partly there
+    clearTilesBetween((double) (start - PeakPyramid::baseBinSize), (double) numFramesReady);
+    repaint();
+
+    if (numFramesReady == view.numFrames)
+        mPartialPeaks = nullptr;
+}
+
+float WaveThumbnail::frameToX(double frame) const
+{
+    return (float) ((frame - mVisibleRange.getStart()) * getWidth() / mVisibleRange.getLength());
+}
+
+Peak WaveThumbnail::getPeakForRange(const SampleView& view, double startFrame, double endFrame) const
+{
+    // zoomed in further than the finest level, read the handful of frames directly
+    if (endFrame - startFrame < PeakPyramid::baseBinSize && endFrame <= view.getNumFramesReady()) {
+        auto first = juce::jmax(0, (int) startFrame);
+        auto last = juce::jmax(first + 1, (int) std::ceil(endFrame));
+        auto data = view.getChannel(0);
+
+        Peak peak{ data[first], data[first], 0.0f };
+        float sumOfSquares = 0.0f;
+
+        for (int i = first; i < last; ++i) {
+            peak.min = juce::jmin(peak.min, data[i]);
+            peak.max = juce::jmax(peak.max, data[i]);
+            sumOfSquares += data[i] * data[i];
+        }
+
+        peak.rms = std::sqrt(sumOfSquares / (float) (last - first));
+        return peak;
     }
+
+    return mPeaks->getPeak(0, startFrame, endFrame);
 }
 
 void WaveThumbnail::resized()
@@ -74,10 +249,38 @@ void WaveThumbnail::resized()
 
 }
 
+void WaveThumbnail::mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel)
+{
+    // an empty sample or a range that hasn't been set yet has nothing to zoom around
+    if (mPeaks == nullptr || getWidth() <= 0 || mVisibleRange.getLength() <= 0.0 || mPeaks->getNumFrames() == 0)
+        return;
+
+    auto totalFrames = (double) mPeaks->getNumFrames();
+    auto anchor = mVisibleRange.getStart() + mVisibleRange.getLength() * e.position.x / getWidth();
+
+    // never zoom in past one frame per pixel
+    auto newLength = juce::jlimit(juce::jmin((double) getWidth(), totalFrames), totalFrames,
+                                  mVisibleRange.getLength() * std::pow(2.0, -wheel.deltaY * 4.0));
+
+    auto newStart = anchor - (anchor - mVisibleRange.getStart()) * newLength / mVisibleRange.getLength();
+    newStart = juce::jlimit(0.0, totalFrames - newLength, newStart);
+
+    mVisibleRange = { newStart, newStart + newLength };
+    repaint();
+}
+
+void WaveThumbnail::mouseDoubleClick(const juce::MouseEvent& e)
+{
+    if (mPeaks != nullptr) {
+        mVisibleRange = { 0.0, (double) mPeaks->getNumFrames() };
+        repaint();
+    }
+}
+
 bool WaveThumbnail::isInterestedInFileDrag(const juce::StringArray& files)
 {
     for (auto file : files) {
-        if (file.contains(".wav") || file.contains(".mp3") || file.contains(".aif") || file.contains(".flac")) {
+        if (file.contains(".wav") || file.contains(".mp3") || file.contains(".aif") || file.contains(".flac") || file.contains(".sfz")) {
             return true;
         }
     }
@@ -89,11 +292,71 @@ void WaveThumbnail::filesDropped(const juce::StringArray& files, int x, int y)
 {
     for (auto file : files) {
         if (isInterestedInFileDrag(file)) {
-            auto myFile = std::make_unique<juce::File>(file);
-            mFileName = myFile->getFileNameWithoutExtension();
-
             audioProcessor.loadFile(file);
-            repaint();
         }
     }
+}
+
+void WaveThumbnail::changeListenerCallback(juce::ChangeBroadcaster* source)
+{
+    auto sound = audioProcessor.getLoadedSound();
+
+    auto previousName = mName;
+    auto previousLength = mPeaks != nullptr ? mPeaks->getNumFrames() : 0;
+
+    mPeaks = nullptr;
+    mData = nullptr;
+    mName = {};
+    mSampleChanged = audioProcessor.hasSampleChanged();
+
+    if (auto* sampleSound = dynamic_cast<SampleSound*>(sound.get())) {
+        mPeaks = sampleSound->getPeaks();
+        mData = sampleSound->getData();
+        mName = sampleSound->getName();
+    }
+    else if (auto* streamingSound = dynamic_cast<StreamingSound*>(sound.get())) {
+        // the peaks cover the whole file, only the head is in memory for zooming in
+        mPeaks = streamingSound->getPeaks();
+        mData = streamingSound->getHead();
+        mName = streamingSound->getName() + " (streaming)";
+    }
+
+    auto length = mPeaks != nullptr ? mPeaks->getNumFrames() : 0;
+
+    // the same sample handed back, looped again or done decoding, stays zoomed where it was
+    if (mName != previousName || length != previousLength || mVisibleRange.getEnd() > (double) length)
+        mVisibleRange = { 0.0, (double) length };
+
+    mPartialPeaks = nullptr;
+
+    if (mData != nullptr && !mData->isComplete()) {
+        mPartialPeaks = std::make_unique<PeakPyramid::Builder>(mData->getNumChannels());
+        updatePartialPeaks();
+    }
+
+    clearTiles();
+    repaint();
+}
+
+void WaveThumbnail::timerCallback()
+{
+    auto now = juce::Time::getMillisecondCounter();
+
+    if (mPartialPeaks != nullptr && now - mLastPeakUpdate >= 1000 / peakUpdateHz) {
+        mLastPeakUpdate = now;
+        updatePartialPeaks();
+    }
+
+    auto numPositions = audioProcessor.getVoicePositions(mNewVoicePositions.data(), (int) mNewVoicePositions.size());
+    auto loopSettings = audioProcessor.getLoopSettings();
+
+    jassert(numPositions == (int) mNewVoicePositions.size());
+    juce::ignoreUnused(numPositions);
+
+    // the waveform itself comes from the tiles, a repaint here is only blits and lines
+    if (mNewVoicePositions != mVoicePositions || loopSettings != mLoopSettings) {
+        std::swap(mVoicePositions, mNewVoicePositions);
+        mLoopSettings = loopSettings;
+        repaint();
+    }
 }
\ No newline at end of file
@@ -12,27 +12,96 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "PeakPyramid.h"
 
 //==============================================================================
 /*
+    Draws the loaded sample from its peak pyramid, one column per pixel, so painting
+    and zooming cost the same whatever the length of the file. The mouse wheel zooms
+    around the cursor, a double click shows the whole sample again.
+
+    The waveform is drawn into image tiles tileWidth columns wide, which are kept
+    until the sample, the size or the zoom changes. A repaint only draws the tiles
+    that aren't cached yet, and blits the others. The loop region and the position
+    of every playing voice go on top, and are checked for changes timerHz times a
+    second.
+
+    A sample that's still being decoded is summarised here as its frames come in,
+    peakUpdateHz times a second, and only the tiles over the new frames are redrawn.
 */
-class WaveThumbnail  : public juce::Component, public juce::FileDragAndDropTarget
+class WaveThumbnail  : public juce::Component, public juce::FileDragAndDropTarget,
+                       private juce::ChangeListener, private juce::Timer
 {
 public:
+    static constexpr int tileWidth = 256;
+    static constexpr int maxTiles = 32;
+    static constexpr int timerHz = 60;
+    static constexpr int peakUpdateHz = 10;
+
     WaveThumbnail(YellowRoseAudioProcessor& p);
     ~WaveThumbnail() override;
 
     void paint (juce::Graphics&) override;
     void resized() override;
 
-    bool juce::FileDragAndDropTarget::isInterestedInFileDrag(const juce::StringArray& files);
-    void juce::FileDragAndDropTarget::filesDropped(const juce::StringArray& files, int x, int y);
+    /** Drops the cached tiles, so the next paint draws the waveform from scratch. */
+    void clearTiles();
+
+    void mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override;
+    void mouseDoubleClick(const juce::MouseEvent& e) override;
+
+    bool isInterestedInFileDrag(const juce::StringArray& files) override;
+    void filesDropped(const juce::StringArray& files, int x, int y) override;
 
 private:
-    std::vector<float> mAudioPoints;
-    bool mShouldBePainting{ false };
+    struct Tile
+    {
+        juce::int64 index;
+        juce::Image image;
+        juce::uint32 lastUsed;
+    };
+
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void timerCallback() override;
+
+    void paintWaveform(juce::Graphics& g);
+    void paintOverlays(juce::Graphics& g);
+
+    /** Drops the tiles that show any of the frames in the range. */
+    void clearTilesBetween(double startFrame, double endFrame);
+
+    /** Adds the frames decoded since the last call to the partial peaks. */
+    void updatePartialPeaks();
+
+    const juce::Image& getTile(juce::int64 index, double framesPerPixel, float scale);
+    juce::Image renderTile(juce::int64 index, double framesPerPixel, float scale) const;
+
+    float frameToX(double frame) const;
+
+    Peak getPeakForRange(const SampleView& view, double startFrame, double endFrame) const;
+
+    // what's being drawn, picked up from the processor when the sound changes
+    PeakPyramid::Ptr mPeaks;
+    SampleData::Ptr mData;
+    juce::String mName;
+    bool mSampleChanged{ false };
+
+    // for a sample that's still being decoded, null once it's all there
+    std::unique_ptr<PeakPyramid::Builder> mPartialPeaks;
+    juce::uint32 mLastPeakUpdate{ 0 };
+
+    juce::Range<double> mVisibleRange;
+
+    // the tiles hold columns of this many frames, at this height and pixel scale
+    std::vector<Tile> mTiles;
+    double mTileFramesPerPixel{ 0.0 };
+    int mTileHeight{ 0 };
+    float mTileScale{ 0.0f };
+    juce::uint32 mTileCounter{ 0 };
 
-    juce::String mFileName{ "" };
+    // what the overlays showed last time, so the timer only repaints when it changes
+    std::vector<float> mVoicePositions, mNewVoicePositions;
+    LoopSettings mLoopSettings;
 
     YellowRoseAudioProcessor& audioProcessor;
 
@@ -0,0 +1,429 @@
+/*
+  ==============================================================================
+
+    YellowRoseSynth.cpp
+    Created: 2 Nov 2024 8:03:37pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "YellowRoseSynth.h"
+#include "YellowRoseVoice.h"
+#include "SampleVoice.h"
+
+YellowRoseSynth::YellowRoseSynth()
+{
+    // swapSound() relies on never having to grow the array
+    sounds.ensureStorageAllocated(1);
+
+    mBusChannels.fill(-1);
+    mBusChannels[0] = 0;
+
+    mPitchWheelValues.fill(8192);
+}
+
+void YellowRoseSynth::prepare(double sampleRate, int maxBlockSize)
+{
+    setCurrentPlaybackSampleRate(sampleRate);
+    mFilter.setSampleRate(sampleRate);
+
+    mActiveVoices.ensureStorageAllocated(voices.size());
+    mBusVoices.ensureStorageAllocated(voices.size());
+    mStartedVoices.ensureStorageAllocated(voices.size());
+    mVoiceBank.prepare(voices.size());
+
+    // leave a core for the host and one for the audio thread, which renders too
+    auto numWorkers = juce::jlimit(0, 3, juce::SystemStats::getNumCpus() - 2);
+
+    if (numWorkers > 0)
+        mRenderPool.prepare(numWorkers, maxBlockSize, voices.size());
+    else
+        mRenderPool.release();
+}
+
+void YellowRoseSynth::setRenderThreadsRunning(bool shouldRun)
+{
+    mRenderPool.setWorkersRunning(shouldRun);
+}
+
+void YellowRoseSynth::setOutputBusChannel(int bus, int firstChannel) noexcept
+{
+    // bus 0 always plays, it's where everything else falls back to
+    if (bus > 0 && bus < maxOutputBuses)
+        mBusChannels[(size_t) bus] = firstChannel;
+}
+
+void YellowRoseSynth::releaseResources()
+{
+    mRenderPool.release();
+}
+
+void YellowRoseSynth::swapSound(juce::SynthesiserSound* newSound)
+{
+    if (sounds.isEmpty())
+        sounds.add(newSound);
+    else
+        sounds.set(0, newSound);
+}
+
+bool YellowRoseSynth::isContinuousControl(const juce::MidiMessage& message) noexcept
+{
+    if (message.isPitchWheel() || message.isChannelPressure() || message.isAftertouch())
+        return true;
+
+    if (!message.isController())
+        return false;
+
+    // the pedals decide when notes end and 120 up are channel mode messages, those keep their timing
+    auto number = message.getControllerNumber();
+    return number < 120 && number != 64 && number != 66 && number != 67;
+}
+
+void YellowRoseSynth::renderBlock(juce::AudioBuffer<float>& outputAudio, const juce::MidiBuffer& midiData,
+                                  int startSample, int numSamples)
+{
+    if (getSampleRate() <= 0.0)
+        return;
+
+    const auto interval = mControlInterval.load(std::memory_order_relaxed);
+    const auto end = startSample + numSamples;
+    auto controlPointBefore = [&](int time) { return startSample + (time - startSample) / interval * interval; };
+
+    auto it = midiData.findNextSamplePosition(startSample);
+    auto position = startSample;
+
+    while (position < end) {
+        auto nextControlPoint = controlPointBefore(position) + interval;
+        auto spanEnd = end;
+
+        // handle everything that's due at this position, the first event that isn't
+        // decides where the span ends
+        for (; it != midiData.cend(); ++it) {
+            const auto metadata = *it;
+
+            if (metadata.samplePosition >= end)
+                break;
+
+            auto message = metadata.getMessage();
+
+            if (isContinuousControl(message)) {
+                if (metadata.samplePosition >= nextControlPoint) {
+                    spanEnd = controlPointBefore(metadata.samplePosition);
+                    break;
+                }
+            }
+            else if (metadata.samplePosition > position) {
+                spanEnd = metadata.samplePosition;
+                break;
+            }
+
+            handleMidiEvent(message);
+        }
+
+        renderVoices(outputAudio, position, spanEnd - position);
+        position = spanEnd;
+    }
+
+    // like juce::Synthesiser, events past the end of the block are handled after it
+    for (; it != midiData.cend(); ++it)
+        handleMidiEvent((*it).getMessage());
+}
+
+void YellowRoseSynth::renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    // only the audio thread writes this
+    mNumRenderSpans.store(mNumRenderSpans.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    mActiveVoices.clearQuick();
+    juce::uint32 busesUsed = 0;
+
+    for (auto* voice : voices) {
+        // a plain member read, idle voices never get a virtual call
+        if (voice->getCurrentlyPlayingNote() >= 0) {
+            mActiveVoices.add(voice);
+            busesUsed |= 1u << getBusFor(*voice);
+        }
+    }
+
+    auto numActive = mActiveVoices.size();
+    mNumActiveVoices.store(numActive, std::memory_order_relaxed);
+
+    // the usual case, everything on the main output
+    if (busesUsed <= 1) {
+        renderGroup(mActiveVoices.getRawDataPointer(), numActive, outputAudio, startSample, numSamples);
+        return;
+    }
+
+    for (int bus = 0; bus < maxOutputBuses; ++bus) {
+        if ((busesUsed & (1u << bus)) == 0)
+            continue;
+
+        mBusVoices.clearQuick();
+
+        for (auto* voice : mActiveVoices)
+            if (getBusFor(*voice) == bus)
+                mBusVoices.add(voice);
+
+        // refers to the bus's channels of the host buffer, no allocation for two channels
+        auto firstChannel = mBusChannels[(size_t) bus];
+        auto numChannels = juce::jmin(2, outputAudio.getNumChannels() - firstChannel);
+
+        if (numChannels <= 0) {
+            jassertfalse; // the layout changed without setOutputBusChannel() being told
+            continue;
+        }
+
+        float* channels[] = { outputAudio.getWritePointer(firstChannel),
+                              numChannels > 1 ? outputAudio.getWritePointer(firstChannel + 1) : nullptr };
+        juce::AudioBuffer<float> busAudio(channels, numChannels, outputAudio.getNumSamples());
+
+        renderGroup(mBusVoices.getRawDataPointer(), mBusVoices.size(), busAudio, startSample, numSamples);
+    }
+}
+
+int YellowRoseSynth::getBusFor(const juce::SynthesiserVoice& voice) const noexcept
+{
+    // every voice of this synthesiser is one of ours
+    auto bus = static_cast<const YellowRoseVoice&>(voice).getOutputBus();
+    return bus > 0 && bus < maxOutputBuses && mBusChannels[(size_t) bus] >= 0 ? bus : 0;
+}
+
+void YellowRoseSynth::renderGroup(juce::SynthesiserVoice* const* groupVoices, int numVoices,
+                                  juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    const auto* filter = mFilter.isActive() ? &mFilter : nullptr;
+
+    if (mMultithreaded && numVoices >= minVoicesForThreads
+        && mRenderPool.render(groupVoices, numVoices, filter, outputAudio, startSample, numSamples))
+        return;
+
+    if (filter != nullptr) {
+        filter->process(groupVoices, numVoices, outputAudio, startSample, numSamples);
+        return;
+    }
+
+    if (mUsesVoiceBank.load(std::memory_order_relaxed)) {
+        mVoiceBank.render(groupVoices, numVoices, outputAudio, startSample, numSamples);
+        return;
+    }
+
+    for (int i = 0; i < numVoices; ++i)
+        groupVoices[i]->renderNextBlock(outputAudio, startSample, numSamples);
+}
+
+juce::SynthesiserVoice* YellowRoseSynth::findFreeVoice(juce::SynthesiserSound* soundToPlay, int midiChannel,
+                                                       int midiNoteNumber, bool stealIfNoneAvailable) const
+{
+    int numActive = 0;
+    juce::SynthesiserVoice* freeVoice = nullptr;
+
+    for (auto* voice : voices) {
+        if (voice->isVoiceActive())
+            ++numActive;
+        else if (freeVoice == nullptr && voice->canPlaySound(soundToPlay))
+            freeVoice = voice;
+    }
+
+    if (freeVoice != nullptr && numActive < mPolyphony.load())
+        return freeVoice;
+
+    if (stealIfNoneAvailable) {
+        if (auto* stolen = findVoiceToSteal(soundToPlay, midiChannel, midiNoteNumber))
+            return stolen;
+    }
+
+    // nothing that can play this sound is active, so there's nothing to steal from
+    return freeVoice;
+}
+
+juce::SynthesiserVoice* YellowRoseSynth::findVoiceToSteal(juce::SynthesiserSound* soundToPlay, int /*midiChannel*/,
+                                                          int midiNoteNumber) const
+{
+    const auto policy = mStealingPolicy.load();
+    juce::SynthesiserVoice* best = nullptr;
+
+    // lower is a better candidate; voices that are already releasing always go first
+    auto score = [policy](juce::SynthesiserVoice* voice) {
+        auto releasing = voice->isPlayingButReleased() ? 0.0f : 2.0f;
+
+        if (policy == StealingPolicy::quietest)
+            return releasing + static_cast<YellowRoseVoice*>(voice)->getLevel();
+
+        return releasing;
+    };
+
+    for (auto* voice : voices) {
+        if (!voice->isVoiceActive() || !voice->canPlaySound(soundToPlay) || mStartedVoices.contains(voice))
+            continue;
+
+        if (policy == StealingPolicy::sameNote && voice->getCurrentlyPlayingNote() == midiNoteNumber)
+            return voice;
+
+        if (best == nullptr) {
+            best = voice;
+            continue;
+        }
+
+        auto voiceScore = score(voice);
+        auto bestScore = score(best);
+
+        // ties, and the oldest and same-note policies in general, go to the voice started first
+        if (voiceScore < bestScore || (voiceScore == bestScore && voice->wasStartedBefore(*best)))
+            best = voice;
+    }
+
+    return best;
+}
+//==============================================================================
+// juce::Synthesiser's handlers without its lock, see the class comment
+void YellowRoseSynth::noteOn(int midiChannel, int midiNoteNumber, float velocity)
+{
+    for (auto* sound : sounds) {
+        if (!sound->appliesToNote(midiNoteNumber) || !sound->appliesToChannel(midiChannel))
+            continue;
+
+        // a note that's still ringing from a pedal is stopped before it starts again
+        for (auto* voice : voices)
+            if (voice->getCurrentlyPlayingNote() == midiNoteNumber && voice->isPlayingChannel(midiChannel))
+                voice->stopNote(1.0f, true);
+
+        mStartedVoices.clearQuick();
+
+        auto start = [&](const KeyZone* zone) {
+            auto* voice = findFreeVoice(sound, midiChannel, midiNoteNumber, isNoteStealingEnabled());
+
+            if (voice == nullptr)
+                return;
+
+            // findFreeVoice() only returns voices that can play the sound, and only SampleVoices play SampleSounds
+            if (zone != nullptr)
+                static_cast<SampleVoice*>(voice)->setNextZone(zone);
+
+            startVoice(voice, sound, midiChannel, midiNoteNumber, velocity);
+            mStartedVoices.add(voice);
+
+            // startVoice() passes the base class's wheel position, which only its own locking handler keeps
+            voice->pitchWheelMoved(mPitchWheelValues[(size_t) juce::jlimit(0, 16, midiChannel)]);
+            voice->setSustainPedalDown(mSustainPedalsDown[(size_t) juce::jlimit(0, 16, midiChannel)]);
+        };
+
+        // a voice per layer, and none stolen for a gap in the velocity map
+        if (auto* sampleSound = dynamic_cast<SampleSound*>(sound)) {
+            for (auto* zone : sampleSound->getKeymap().findLayers(midiNoteNumber, juce::roundToInt(velocity * 127.0f)))
+                start(zone);
+        }
+        else {
+            start(nullptr);
+        }
+    }
+}
+
+void YellowRoseSynth::noteOff(int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff)
+{
+    for (auto* voice : voices) {
+        if (voice->getCurrentlyPlayingNote() != midiNoteNumber || !voice->isPlayingChannel(midiChannel))
+            continue;
+
+        if (auto sound = voice->getCurrentlyPlayingSound()) {
+            if (sound->appliesToNote(midiNoteNumber) && sound->appliesToChannel(midiChannel)) {
+                voice->setKeyDown(false);
+
+                if (!isPedalHeld(*voice))
+                    voice->stopNote(velocity, allowTailOff);
+            }
+        }
+    }
+}
+
+void YellowRoseSynth::allNotesOff(int midiChannel, bool allowTailOff)
+{
+    for (auto* voice : voices)
+        if (midiChannel <= 0 || voice->isPlayingChannel(midiChannel))
+            voice->stopNote(1.0f, allowTailOff);
+
+    mSustainPedalsDown.fill(false);
+}
+
+void YellowRoseSynth::handlePitchWheel(int midiChannel, int wheelValue)
+{
+    mPitchWheelValues[(size_t) juce::jlimit(0, 16, midiChannel)] = wheelValue;
+
+    for (auto* voice : voices)
+        if (voice->isPlayingChannel(midiChannel))
+            voice->pitchWheelMoved(wheelValue);
+}
+
+void YellowRoseSynth::handleController(int midiChannel, int controllerNumber, int controllerValue)
+{
+    switch (controllerNumber) {
+    case 0x40: handleSustainPedal(midiChannel, controllerValue >= 64); break;
+    case 0x42: handleSostenutoPedal(midiChannel, controllerValue >= 64); break;
+    case 0x43: handleSoftPedal(midiChannel, controllerValue >= 64); break;
+    default: break;
+    }
+
+    for (auto* voice : voices)
+        if (voice->isPlayingChannel(midiChannel))
+            voice->controllerMoved(controllerNumber, controllerValue);
+}
+
+void YellowRoseSynth::handleAftertouch(int midiChannel, int midiNoteNumber, int aftertouchValue)
+{
+    for (auto* voice : voices)
+        if (voice->getCurrentlyPlayingNote() == midiNoteNumber && (midiChannel <= 0 || voice->isPlayingChannel(midiChannel)))
+            voice->aftertouchChanged(aftertouchValue);
+}
+
+void YellowRoseSynth::handleChannelPressure(int midiChannel, int channelPressureValue)
+{
+    for (auto* voice : voices)
+        if (midiChannel <= 0 || voice->isPlayingChannel(midiChannel))
+            voice->channelPressureChanged(channelPressureValue);
+}
+
+void YellowRoseSynth::handleSustainPedal(int midiChannel, bool isDown)
+{
+    if (midiChannel < 1 || midiChannel > 16)
+        return;
+
+    mSustainPedalsDown[(size_t) midiChannel] = isDown;
+
+    for (auto* voice : voices) {
+        if (!voice->isPlayingChannel(midiChannel))
+            continue;
+
+        if (isDown) {
+            if (voice->isKeyDown())
+                voice->setSustainPedalDown(true);
+        }
+        else {
+            voice->setSustainPedalDown(false);
+
+            if (!voice->isKeyDown() && !voice->isSostenutoPedalDown())
+                voice->stopNote(1.0f, true);
+        }
+    }
+}
+
+void YellowRoseSynth::handleSostenutoPedal(int midiChannel, bool isDown)
+{
+    for (auto* voice : voices) {
+        if (!voice->isPlayingChannel(midiChannel))
+            continue;
+
+        if (isDown)
+            voice->setSostenutoPedalDown(true);
+        else if (voice->isSostenutoPedalDown())
+            voice->stopNote(1.0f, true);
+    }
+}
+
+void YellowRoseSynth::handleSoftPedal(int /*midiChannel*/, bool /*isDown*/)
+{
+}
+
+bool YellowRoseSynth::isPedalHeld(const juce::SynthesiserVoice& voice) const noexcept
+{
+    return voice.isSustainPedalDown() || voice.isSostenutoPedalDown();
+}
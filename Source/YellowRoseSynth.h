@@ -0,0 +1,178 @@
+/*
+  ==============================================================================
+
+    YellowRoseSynth.h
+    Created: 2 Nov 2024 8:03:37pm
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "VoiceRenderPool.h"
+#include "VoiceBank.h"
+
+//==============================================================================
+/*
+    The sampler's synthesiser. Adds a real-time safe way to replace the playing
+    sound from inside the audio callback.
+
+    All voices are created up front and the polyphony limit only decides how many
+    of them may play at once. Past the limit a voice is stolen according to the
+    stealing policy. Voices that aren't playing are skipped without a call.
+
+    With multithreading on, blocks with enough active voices are rendered on a
+    VoiceRenderPool. With the filter on, voices go through the VoiceFilter in
+    groups instead of rendering straight into the output. Otherwise they render
+    straight into it through the VoiceBank, which juce::Synthesiser's voice objects
+    only start and stop.
+
+    renderBlock() replaces juce::Synthesiser::renderNextBlock: notes still start
+    and stop on their exact sample, but controllers, pitch-bend and pressure are
+    only applied every control interval, so a dense controller stream doesn't cut
+    the block into lots of tiny renders.
+
+    The voices and the sound only change in the constructor, in prepare() and in
+    swapSound() on the audio thread itself, so nothing else ever holds
+    juce::Synthesiser's lock while the audio thread runs. The MIDI handlers are
+    overridden with versions that don't take it, and the audio path takes no lock.
+
+    Voices play on one of up to maxOutputBuses stereo outputs, picked by the zone
+    they started from. Each bus's voices render straight into that bus's channels
+    of the host buffer, there's no scratch buffer to copy from afterwards. On the
+    render pool only the first task of each bus does: the others run on other
+    threads at the same time, and are added in once they're done. The filter needs
+    each voice dry before it mixes the filtered voices into the bus.
+*/
+class YellowRoseSynth  : public juce::Synthesiser
+{
+public:
+    enum class StealingPolicy
+    {
+        oldest = 0,
+        quietest,
+        sameNote
+    };
+
+    static juce::StringArray getStealingPolicyNames() { return { "Oldest", "Quietest", "Same note" }; }
+
+    static constexpr int minVoicesForThreads = 8;
+    static constexpr int defaultControlInterval = 32;
+    static constexpr int maxOutputBuses = 8;
+
+    YellowRoseSynth();
+
+    /** Call from prepareToPlay, once all the voices have been added. */
+    void prepare(double sampleRate, int maxBlockSize);
+    void releaseResources();
+
+    /** Safe to call from the audio thread. Multithreading also needs the render threads
+        running, see setRenderThreadsRunning().
+    */
+    void setPolyphony(int numVoices) noexcept { mPolyphony = juce::jmax(1, numVoices); }
+    void setStealingPolicy(StealingPolicy policy) noexcept { mStealingPolicy = policy; }
+    void setMultithreaded(bool shouldUseThreads) noexcept { mMultithreaded = shouldUseThreads; }
+
+    /** On by default. Off, every voice renders on its own, for comparing the two. */
+    void setUsesVoiceBank(bool shouldUse) noexcept { mUsesVoiceBank = shouldUse; }
+
+    /** Starts or stops the worker threads, they're stopped after prepare(). Not on the
+        audio thread, but while it renders is fine.
+    */
+    void setRenderThreadsRunning(bool shouldRun);
+
+    /** Frames between the points continuous controllers are applied at. Safe to call from the audio thread. */
+    void setControlInterval(int numSamples) noexcept { mControlInterval = juce::jmax(1, numSamples); }
+
+    /** Where an output bus starts in the buffers renderBlock() gets, or -1 if the
+        host hasn't enabled it. Voices on a bus that's off play on bus 0. Call from
+        prepareToPlay, not while the audio thread is rendering.
+    */
+    void setOutputBusChannel(int bus, int firstChannel) noexcept;
+
+    /** Audio thread only. */
+    void setFilterSettings(const VoiceFilter::Settings& settings) noexcept { mFilter.setSettings(settings); }
+
+    /** Renders the block, splitting it at every distinct note event time and at the
+        control points that have controller events waiting. A controller is applied
+        at the start of the control interval it falls in, or at the last note event
+        before it if that's later, so events are always handled in order.
+    */
+    void renderBlock(juce::AudioBuffer<float>& outputAudio, const juce::MidiBuffer& midiData, int startSample, int numSamples);
+
+    /** Controllers other than the pedals and channel mode messages, pitch-bend and pressure. */
+    static bool isContinuousControl(const juce::MidiMessage& message) noexcept;
+
+    VoiceRenderPool::Stats getRenderPoolStats() const { return mRenderPool.getStats(); }
+
+    /** Number of voices that rendered anything in the last block. */
+    int getNumActiveVoices() const noexcept { return mNumActiveVoices.load(std::memory_order_relaxed); }
+
+    /** Number of spans the voices have been rendered in, whichever render call split the blocks. */
+    juce::int64 getNumRenderSpans() const noexcept { return mNumRenderSpans.load(std::memory_order_relaxed); }
+
+    /** Replaces the current sound without allocating. Must be called on the audio
+        thread, and the caller must make sure someone else still holds a reference
+        to the old sound so it isn't deleted here.
+    */
+    void swapSound(juce::SynthesiserSound* newSound);
+
+    //==============================================================================
+    void noteOn(int midiChannel, int midiNoteNumber, float velocity) override;
+    void noteOff(int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff) override;
+    void allNotesOff(int midiChannel, bool allowTailOff) override;
+    void handlePitchWheel(int midiChannel, int wheelValue) override;
+    void handleController(int midiChannel, int controllerNumber, int controllerValue) override;
+    void handleAftertouch(int midiChannel, int midiNoteNumber, int aftertouchValue) override;
+    void handleChannelPressure(int midiChannel, int channelPressureValue) override;
+    void handleSustainPedal(int midiChannel, bool isDown) override;
+    void handleSostenutoPedal(int midiChannel, bool isDown) override;
+    void handleSoftPedal(int midiChannel, bool isDown) override;
+
+protected:
+    void renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+
+    juce::SynthesiserVoice* findFreeVoice(juce::SynthesiserSound* soundToPlay, int midiChannel,
+                                          int midiNoteNumber, bool stealIfNoneAvailable) const override;
+    juce::SynthesiserVoice* findVoiceToSteal(juce::SynthesiserSound* soundToPlay, int midiChannel,
+                                             int midiNoteNumber) const override;
+
+private:
+    std::atomic<int> mPolyphony{ 16 };
+    std::atomic<StealingPolicy> mStealingPolicy{ StealingPolicy::oldest };
+    std::atomic<int> mNumActiveVoices{ 0 };
+    std::atomic<int> mControlInterval{ defaultControlInterval };
+    std::atomic<juce::int64> mNumRenderSpans{ 0 };
+
+    std::atomic<bool> mMultithreaded{ false };
+    VoiceRenderPool mRenderPool;
+    VoiceFilter mFilter;
+    VoiceBank mVoiceBank;
+    std::atomic<bool> mUsesVoiceBank{ true };
+    juce::Array<juce::SynthesiserVoice*> mActiveVoices, mBusVoices;
+
+    // the layers the current noteOn() has started so far, which mustn't steal from each other
+    juce::Array<juce::SynthesiserVoice*> mStartedVoices;
+
+    // first channel of each output bus, -1 for buses that are off
+    std::array<int, maxOutputBuses> mBusChannels;
+
+    // juce::Synthesiser keeps its own privately, indexed by channel 1 to 16
+    std::array<bool, 17> mSustainPedalsDown{};
+
+    // the same for the pitch wheels
+    std::array<int, 17> mPitchWheelValues;
+
+    bool isPedalHeld(const juce::SynthesiserVoice& voice) const noexcept;
+
+    /** The bus the voice renders into, after falling back for buses that are off. */
+    int getBusFor(const juce::SynthesiserVoice& voice) const noexcept;
+
+    /** Renders voices that share a bus, on the pool or through the filter if those are on. */
+    void renderGroup(juce::SynthesiserVoice* const* groupVoices, int numVoices,
+                     juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (YellowRoseSynth)
+};
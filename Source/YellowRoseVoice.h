@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    YellowRoseVoice.h
+    Created: 7 Dec 2024 10:26:51am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Envelope.h"
+
+//==============================================================================
+/*
+    Base class for the sampler's voices. Owns the amplitude envelope, and exposes
+    what the synthesiser needs to pick a voice to steal.
+
+    Also holds the voice's filter state and filter envelope. The voice only starts
+    and releases them, VoiceFilter runs the filter over several voices at once.
+*/
+class YellowRoseVoice  : public juce::SynthesiserVoice
+{
+public:
+    struct FilterState
+    {
+        Envelope envelope;
+
+        // the integrator states per channel, and the coefficients the last slice ended on
+        float ic1[2]{}, ic2[2]{};
+        float a1{ 0.0f }, a2{ 0.0f }, a3{ 0.0f };
+        bool hasCoefficients{ false };
+
+        int note{ 60 };
+    };
+
+    static constexpr double pitchBendSemitones = 2.0;
+
+    /** The gain the voice was applying at the end of the last block it rendered. */
+    float getLevel() const noexcept { return mLevel; }
+
+    /** True for voices a VoiceBank can render, which are all SampleVoices. */
+    bool rendersInVoiceBank() const noexcept { return mRendersInVoiceBank; }
+
+    /** The output bus the zone of the note that's playing asked for, 0 for the main one. */
+    int getOutputBus() const noexcept { return mOutputBus; }
+
+    /** How far through its sample the note was at the end of the last block, from 0
+        to 1, or -1 if nothing's playing. For the editor, safe from any thread.
+    */
+    float getDisplayPosition() const noexcept { return mDisplayPosition.load(std::memory_order_relaxed); }
+
+    /** Audio thread only. Applies to the note that's playing as well. */
+    void setEnvelopeParameters(const juce::ADSR::Parameters& parameters) noexcept { mEnvelope.setParameters(parameters); }
+
+    /** Audio thread only, like setEnvelopeParameters(). */
+    void setFilterEnvelopeParameters(const juce::ADSR::Parameters& parameters) noexcept { mFilter.envelope.setParameters(parameters); }
+
+    /** Audio thread only, for VoiceFilter. */
+    FilterState& getFilterState() noexcept { return mFilter; }
+
+    /** Bends the note that's playing, and the next one started, by up to
+        pitchBendSemitones either way. The synthesiser applies it at control
+        points, so a bend lands where the scheduler puts controllers.
+    */
+    void pitchWheelMoved(int newValue) override
+    {
+        mBendRatio = std::pow(2.0, (newValue - 8192) / 8192.0 * pitchBendSemitones / 12.0);
+        mPitchRatio = mUnbentRatio * mBendRatio;
+    }
+
+    void setCurrentPlaybackSampleRate(double newRate) override
+    {
+        juce::SynthesiserVoice::setCurrentPlaybackSampleRate(newRate);
+
+        if (newRate > 0.0) {
+            mEnvelope.setSampleRate(newRate);
+            mFilter.envelope.setSampleRate(newRate);
+        }
+    }
+
+protected:
+    /** Next to the amplitude envelope's noteOn(), a new note starts from a silent filter. */
+    void startFilter(int midiNoteNumber) noexcept
+    {
+        std::fill(std::begin(mFilter.ic1), std::end(mFilter.ic1), 0.0f);
+        std::fill(std::begin(mFilter.ic2), std::end(mFilter.ic2), 0.0f);
+        mFilter.hasCoefficients = false;
+        mFilter.note = midiNoteNumber;
+        mFilter.envelope.noteOn();
+    }
+
+    void releaseFilter() noexcept { mFilter.envelope.noteOff(); }
+
+    /** Scales the gains by a straight line from one level to another over the chunk. */
+    static void applyRamp(float* gains, int numFrames, float from, float to) noexcept
+    {
+        auto step = (to - from) / (float) numFrames;
+
+        for (int i = 0; i < numFrames; ++i)
+            gains[i] *= from + step * (float) (i + 1);
+    }
+
+    /** Sets the step through the sample before any bend, in startNote(). */
+    void setUnbentPitchRatio(double ratio) noexcept
+    {
+        mUnbentRatio = ratio;
+        mPitchRatio = ratio * mBendRatio;
+    }
+
+    Envelope mEnvelope;
+    FilterState mFilter;
+    float mLevel{ 0.0f };
+    double mSourceSamplePosition{ 0.0 };
+    double mPitchRatio{ 0.0 };
+    int mOutputBus{ 0 }; // set by startNote(), the synthesiser renders the voice into that bus
+    std::atomic<float> mDisplayPosition{ -1.0f };
+    bool mRendersInVoiceBank{ false };
+
+private:
+    double mUnbentRatio{ 1.0 }, mBendRatio{ 1.0 };
+};
@@ -0,0 +1,628 @@
+/*
+  ==============================================================================
+
+    BenchmarkSuite.cpp
+    Created: 15 Feb 2025 11:02:44am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#include "BenchmarkSuite.h"
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/SampleLoader.h"
+#include "../../Source/SampleVoice.h"
+#include "../../Source/WaveThumbnail.h"
+#include "../../Source/MidiBenchmark.h"
+
+namespace
+{
+    constexpr int loadTimeoutMs = 60000;
+
+    // notes within an octave of the root, so no voice runs off the end of its sample,
+    // and a channel for every 24 so none of them retrigger another
+    constexpr int notesPerChannel = 24;
+    constexpr int lowestNote = 48;
+
+    double ticksToSeconds(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks);
+    }
+
+    void setParameter(YellowRoseAudioProcessor& processor, const juce::String& id, float value)
+    {
+        auto* parameter = processor.getAPVTS().getParameter(id);
+        jassert(parameter != nullptr);
+
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    std::unique_ptr<YellowRoseAudioProcessor> createProcessor(const juce::File& sample, double sampleRate, int blockSize)
+    {
+        auto processor = std::make_unique<YellowRoseAudioProcessor>();
+
+        // decoded whole and kept out of the user's sample cache
+        processor->setNonRealtime(true);
+        processor->setUsesSampleCache(false);
+        processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor->prepareToPlay(sampleRate, blockSize);
+
+        setParameter(*processor, "POLYPHONY", (float) YellowRoseAudioProcessor::maxPolyphony);
+        setParameter(*processor, "RELEASE", 0.0f);
+
+        processor->loadFile(sample.getFullPathName());
+        auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) loadTimeoutMs;
+
+        while (!processor->isSampleLoaded()) {
+            if (juce::Time::getMillisecondCounter() > deadline)
+                return nullptr;
+
+            juce::Thread::sleep(5);
+        }
+
+        return processor;
+    }
+
+    void prepare(YellowRoseAudioProcessor& processor, double sampleRate, int blockSize)
+    {
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+    }
+
+    /** Starts the notes in one block of their own, outside the timing. Returns the voices that started. */
+    int startNotes(YellowRoseAudioProcessor& processor, juce::AudioBuffer<float>& buffer, int numNotes)
+    {
+        juce::MidiBuffer midi;
+
+        for (int i = 0; i < numNotes; ++i)
+            midi.addEvent(juce::MidiMessage::noteOn(1 + i / notesPerChannel, lowestNote + i % notesPerChannel, 0.8f), 0);
+
+        buffer.clear();
+        processor.processBlock(buffer, midi);
+        return processor.getNumActiveVoices();
+    }
+
+    void stopNotes(YellowRoseAudioProcessor& processor, juce::AudioBuffer<float>& buffer)
+    {
+        juce::MidiBuffer midi;
+
+        for (int channel = 1; channel <= 16; ++channel)
+            midi.addEvent(juce::MidiMessage::allNotesOff(channel), 0);
+
+        // the release is zero, this only runs out the envelopes' last few frames
+        for (int i = 0; i < 1000 && (i == 0 || processor.getNumActiveVoices() > 0); ++i) {
+            buffer.clear();
+            processor.processBlock(buffer, midi);
+            midi.clear();
+        }
+    }
+
+    /** Runs numBlocks blocks and returns the time spent in processBlock. Called before
+        each block, beforeBlock can change things without being timed.
+    */
+    juce::int64 timeBlocks(YellowRoseAudioProcessor& processor, juce::AudioBuffer<float>& buffer, int numBlocks,
+                           const std::function<void(int)>& beforeBlock = nullptr)
+    {
+        juce::MidiBuffer midi;
+        juce::int64 ticks = 0;
+
+        for (int block = 0; block < numBlocks; ++block) {
+            if (beforeBlock != nullptr)
+                beforeBlock(block);
+
+            buffer.clear();
+            midi.clear();
+
+            auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midi);
+            ticks += juce::Time::getHighResolutionTicks() - start;
+        }
+
+        return ticks;
+    }
+}
+
+//==============================================================================
+juce::String BenchmarkSuite::Measurement::getKey() const
+{
+    auto key = name;
+
+    for (auto& setting : settings)
+        key << " " << setting.name.toString() << "=" << setting.value.toString();
+
+    return key;
+}
+
+//==============================================================================
+BenchmarkSuite::BenchmarkSuite(const Options& options)
+    : mOptions(options),
+      mDirectory(juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("YellowRoseBench"))
+{
+    // whatever a run that didn't finish left behind
+    mDirectory.deleteRecursively();
+    mDirectory.createDirectory();
+
+    mFormatManager.registerBasicFormats();
+}
+
+BenchmarkSuite::~BenchmarkSuite()
+{
+    mDirectory.deleteRecursively();
+}
+
+void BenchmarkSuite::runAll()
+{
+    runProcessBlock();
+    runVoiceBank();
+    runFilter();
+    runEnvelopeUpdates();
+    runLoading();
+    runPainting();
+    runMidiScheduling();
+}
+
+//==============================================================================
+void BenchmarkSuite::runProcessBlock()
+{
+    auto sampleRates = mOptions.quick ? std::vector<double>{ 48000.0 } : std::vector<double>{ 44100.0, 48000.0, 96000.0 };
+    auto blockSizes = mOptions.quick ? std::vector<int>{ 64, 512 } : std::vector<int>{ 32, 64, 128, 256, 512, 1024 };
+    auto voiceCounts = mOptions.quick ? std::vector<int>{ 1, 32, 64, 128 } : std::vector<int>{ 1, 8, 32, 64, 128 };
+    auto seconds = mOptions.quick ? 0.25 : 1.0;
+
+    juce::WavAudioFormat wav;
+
+    for (auto sampleRate : sampleRates) {
+        // long enough for an octave up over the whole render
+        auto sample = writeTestFile(wav, "voice-" + juce::String((int) sampleRate), seconds * 2.0 + 1.0, sampleRate, 2);
+        auto processor = createProcessor(sample, sampleRate, blockSizes.back());
+
+        if (processor == nullptr) {
+            log("processBlock: the sample didn't load");
+            return;
+        }
+
+        for (auto blockSize : blockSizes) {
+            prepare(*processor, sampleRate, blockSize);
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            auto numBlocks = (int) std::ceil(seconds * sampleRate / blockSize);
+
+            for (auto numVoices : voiceCounts) {
+                auto best = std::numeric_limits<juce::int64>::max();
+                int numActive = 0;
+
+                for (int run = 0; run < mOptions.numRuns; ++run) {
+                    numActive = startNotes(*processor, buffer, numVoices);
+                    best = juce::jmin(best, timeBlocks(*processor, buffer, numBlocks));
+                    stopNotes(*processor, buffer);
+                }
+
+                auto numFrames = (double) numBlocks * blockSize;
+                auto secondsTaken = ticksToSeconds(best);
+
+                juce::NamedValueSet settings;
+                settings.set("rate", sampleRate);
+                settings.set("block", blockSize);
+                settings.set("voices", numVoices);
+
+                add("processBlock.perVoice", settings, secondsTaken * 1.0e9 / (numFrames * juce::jmax(1, numActive)), "ns/sample/voice");
+                add("processBlock.load", settings, secondsTaken / (numFrames / sampleRate) * 100.0, "% real time");
+            }
+        }
+    }
+}
+
+void BenchmarkSuite::runVoiceBank()
+{
+    constexpr double sampleRate = 48000.0;
+
+    auto blockSizes = mOptions.quick ? std::vector<int>{ 256 } : std::vector<int>{ 64, 256, 1024 };
+    auto voiceCounts = std::vector<int>{ 64, 128 };
+    auto seconds = mOptions.quick ? 0.25 : 1.0;
+
+    juce::WavAudioFormat wav;
+    auto sample = writeTestFile(wav, "bank", seconds * 2.0 + 1.0, sampleRate, 2);
+    auto processor = createProcessor(sample, sampleRate, blockSizes.back());
+
+    if (processor == nullptr) {
+        log("voiceBank: the sample didn't load");
+        return;
+    }
+
+    for (auto blockSize : blockSizes) {
+        prepare(*processor, sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        auto numBlocks = (int) std::ceil(seconds * sampleRate / blockSize);
+
+        for (auto numVoices : voiceCounts) {
+            // the same notes either way, only how they're rendered differs
+            for (auto usesBank : { false, true }) {
+                processor->setUsesVoiceBank(usesBank);
+
+                auto best = std::numeric_limits<juce::int64>::max();
+                int numActive = 0;
+
+                for (int run = 0; run < mOptions.numRuns; ++run) {
+                    numActive = startNotes(*processor, buffer, numVoices);
+                    best = juce::jmin(best, timeBlocks(*processor, buffer, numBlocks));
+                    stopNotes(*processor, buffer);
+                }
+
+                juce::NamedValueSet settings;
+                settings.set("bank", usesBank ? "on" : "off");
+                settings.set("block", blockSize);
+                settings.set("voices", numVoices);
+
+                add("voiceBank.perVoice", settings, ticksToSeconds(best) * 1.0e9 / ((double) numBlocks * blockSize * juce::jmax(1, numActive)), "ns/sample/voice");
+            }
+        }
+    }
+
+    processor->setUsesVoiceBank(true);
+}
+
+void BenchmarkSuite::runFilter()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+
+    auto voiceCounts = mOptions.quick ? std::vector<int>{ 4, 32 } : std::vector<int>{ 1, 4, 8, 32, 128 };
+    auto seconds = mOptions.quick ? 0.25 : 1.0;
+
+    juce::WavAudioFormat wav;
+    auto sample = writeTestFile(wav, "filter", seconds * 2.0 + 1.0, sampleRate, 2);
+    auto processor = createProcessor(sample, sampleRate, blockSize);
+
+    if (processor == nullptr) {
+        log("filter: the sample didn't load");
+        return;
+    }
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    auto numBlocks = (int) std::ceil(seconds * sampleRate / blockSize);
+
+    // an envelope on the cutoff, so the coefficients move on every slice
+    setParameter(*processor, "CUTOFF", 800.0f);
+    setParameter(*processor, "FILTERENV", 3.0f);
+    setParameter(*processor, "KEYTRACK", 1.0f);
+
+    for (auto type : { FilterType::off, FilterType::lowPass }) {
+        setParameter(*processor, "FILTERTYPE", (float) type);
+
+        for (auto numVoices : voiceCounts) {
+            auto best = std::numeric_limits<juce::int64>::max();
+            int numActive = 0;
+
+            for (int run = 0; run < mOptions.numRuns; ++run) {
+                numActive = startNotes(*processor, buffer, numVoices);
+                best = juce::jmin(best, timeBlocks(*processor, buffer, numBlocks));
+                stopNotes(*processor, buffer);
+            }
+
+            juce::NamedValueSet settings;
+            settings.set("filter", VoiceFilter::getTypeNames()[(int) type]);
+            settings.set("voices", numVoices);
+
+            add("filter.perVoice", settings, ticksToSeconds(best) * 1.0e9 / ((double) numBlocks * blockSize * juce::jmax(1, numActive)), "ns/sample/voice");
+        }
+    }
+}
+
+void BenchmarkSuite::runEnvelopeUpdates()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    constexpr int numVoices = 32;
+
+    juce::WavAudioFormat wav;
+    auto seconds = mOptions.quick ? 0.25 : 1.0;
+    auto sample = writeTestFile(wav, "envelope", seconds * 2.0 + 1.0, sampleRate, 2);
+    auto processor = createProcessor(sample, sampleRate, blockSize);
+
+    if (processor == nullptr) {
+        log("envelope: the sample didn't load");
+        return;
+    }
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    auto numBlocks = (int) std::ceil(seconds * sampleRate / blockSize);
+    auto baseline = std::numeric_limits<juce::int64>::max();
+    auto updating = std::numeric_limits<juce::int64>::max();
+
+    for (int run = 0; run < mOptions.numRuns; ++run) {
+        startNotes(*processor, buffer, numVoices);
+        baseline = juce::jmin(baseline, timeBlocks(*processor, buffer, numBlocks));
+
+        // a different attack every block, each one reaches every voice
+        updating = juce::jmin(updating, timeBlocks(*processor, buffer, numBlocks, [&processor](int block) {
+            setParameter(*processor, "ATTACK", block % 2 == 0 ? 0.01f : 0.02f);
+        }));
+
+        stopNotes(*processor, buffer);
+    }
+
+    juce::NamedValueSet settings;
+    settings.set("rate", sampleRate);
+    settings.set("block", blockSize);
+    settings.set("voices", numVoices);
+
+    add("envelopeUpdate", settings, juce::jmax(0.0, ticksToSeconds(updating - baseline) * 1.0e9 / numBlocks), "ns/update");
+}
+
+void BenchmarkSuite::runLoading()
+{
+    constexpr double sampleRate = 48000.0;
+    auto seconds = mOptions.quick ? 2.0 : 10.0;
+
+    DiskStreamer streamer;
+    SampleLoader loader(streamer);
+    loader.setUsesSampleCache(false);
+    loader.setSavesPeakFiles(false);
+
+    // the first sound handed back, and the complete one, which is the same sound unless the load is progressive
+    std::atomic<juce::int64> firstSoundTicks{ 0 };
+    juce::WaitableEvent loaded;
+
+    loader.onSoundLoaded = [&](juce::SynthesiserSound::Ptr sound, const SampleLoader::SampleReference&) {
+        auto now = juce::Time::getHighResolutionTicks();
+        juce::int64 none = 0;
+        firstSoundTicks.compare_exchange_strong(none, now);
+
+        auto* sampleSound = dynamic_cast<SampleSound*>(sound.get());
+
+        if (sampleSound == nullptr || sampleSound->getData()->isComplete())
+            loaded.signal();
+    };
+
+    for (int i = 0; i < mFormatManager.getNumKnownFormats(); ++i) {
+        auto& format = *mFormatManager.getKnownFormat(i);
+        auto source = writeTestFile(format, "load", seconds, sampleRate, 2);
+
+        // formats that can only be read
+        if (source == juce::File())
+            continue;
+
+        // the plain load keeps its old name, so earlier baselines still compare
+        struct Mode { const char* name; bool progressive, parallel; };
+        const Mode modes[] = { { "load", false, true }, { "load.serial", false, false }, { "load.progressive", true, true } };
+
+        for (auto& mode : modes) {
+            loader.setProgressiveLoading(mode.progressive);
+            loader.setParallelDecoding(mode.parallel);
+
+            auto best = std::numeric_limits<double>::max();
+            auto bestFirstSound = std::numeric_limits<double>::max();
+
+            for (int run = 0; run < mOptions.numRuns; ++run) {
+                // a new name every run, so nothing is found in the SampleStore
+                auto suffix = juce::String((int) (&mode - modes)) + "-" + juce::String(run);
+                auto file = source.getSiblingFile(source.getFileNameWithoutExtension() + suffix).withFileExtension(source.getFileExtension());
+                source.copyFileTo(file);
+
+                loaded.reset();
+                firstSoundTicks = 0;
+                auto start = juce::Time::getHighResolutionTicks();
+                loader.loadFile(file);
+
+                if (!loaded.wait(loadTimeoutMs)) {
+                    log("load: " + format.getFormatName() + " didn't load");
+                    break;
+                }
+
+                best = juce::jmin(best, ticksToSeconds(juce::Time::getHighResolutionTicks() - start));
+                bestFirstSound = juce::jmin(bestFirstSound, ticksToSeconds(firstSoundTicks.load() - start));
+            }
+
+            if (best == std::numeric_limits<double>::max())
+                continue;
+
+            juce::NamedValueSet settings;
+            settings.set("format", format.getFormatName());
+            settings.set("seconds", seconds);
+
+            add(mode.name, settings, best * 1000.0, "ms");
+
+            if (mode.progressive)
+                add("load.firstSound", settings, bestFirstSound * 1000.0, "ms");
+        }
+    }
+
+    loader.shutdown();
+}
+
+void BenchmarkSuite::runPainting()
+{
+    constexpr double sampleRate = 44100.0;
+    constexpr int width = 1200, height = 300;
+    constexpr int numPaints = 50;
+
+    auto lengths = mOptions.quick ? std::vector<double>{ 1.0, 60.0 } : std::vector<double>{ 1.0, 10.0, 60.0, 300.0 };
+
+    juce::WavAudioFormat wav;
+    juce::Image image(juce::Image::ARGB, width, height, true);
+
+    for (auto seconds : lengths) {
+        auto sample = writeTestFile(wav, "paint-" + juce::String((int) seconds), seconds, sampleRate, 1);
+        auto processor = createProcessor(sample, sampleRate, 512);
+
+        if (processor == nullptr) {
+            log("paint: the sample didn't load");
+            return;
+        }
+
+        WaveThumbnail thumbnail(*processor);
+        thumbnail.setSize(width, height);
+
+        // drawing the waveform from scratch, then repaints that find it in the tiles
+        for (auto cached : { false, true }) {
+            auto best = std::numeric_limits<juce::int64>::max();
+
+            for (int run = 0; run < mOptions.numRuns; ++run) {
+                juce::Graphics g(image);
+                auto start = juce::Time::getHighResolutionTicks();
+
+                for (int i = 0; i < numPaints; ++i) {
+                    if (!cached)
+                        thumbnail.clearTiles();
+
+                    thumbnail.paint(g);
+                }
+
+                best = juce::jmin(best, juce::Time::getHighResolutionTicks() - start);
+            }
+
+            juce::NamedValueSet settings;
+            settings.set("seconds", seconds);
+            settings.set("width", width);
+
+            add(cached ? "paint.cached" : "paint", settings, ticksToSeconds(best) * 1.0e6 / numPaints, "us");
+        }
+    }
+}
+
+void BenchmarkSuite::runMidiScheduling()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    auto seconds = mOptions.quick ? 5.0 : 20.0;
+    auto result = MidiBenchmark::run(MidiBenchmark::createStressFile(seconds), sampleRate, blockSize,
+                                     YellowRoseSynth::defaultControlInterval, mOptions.numRuns);
+
+    juce::NamedValueSet settings;
+    settings.set("seconds", seconds);
+    settings.set("block", blockSize);
+
+    add("midi.stock", settings, result.stockMs, "ms");
+    add("midi.scheduled", settings, result.scheduledMs, "ms");
+}
+
+//==============================================================================
+void BenchmarkSuite::add(const juce::String& name, juce::NamedValueSet settings, double value, const juce::String& unit)
+{
+    mMeasurements.push_back({ name, std::move(settings), value, unit });
+    log(mMeasurements.back().getKey() + ": " + juce::String(value, 3) + " " + unit);
+}
+
+void BenchmarkSuite::log(const juce::String& line) const
+{
+    if (mOptions.log != nullptr)
+        mOptions.log(line);
+}
+
+juce::File BenchmarkSuite::writeTestFile(juce::AudioFormat& format, const juce::String& name, double seconds,
+                                         double sampleRate, int numChannels)
+{
+    auto file = mDirectory.getChildFile(name).withFileExtension(format.getFileExtensions()[0]);
+    auto bitDepths = format.getPossibleBitDepths();
+
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+
+    if (!stream->openedOk() || bitDepths.isEmpty())
+        return {};
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                          bitDepths.contains(24) ? 24 : bitDepths.getLast(), {}, 0));
+
+    if (writer == nullptr)
+        return {};
+
+    // the writer owns the stream from here on
+    stream.release();
+
+    constexpr int chunkSize = 1 << 16;
+    juce::AudioBuffer<float> chunk(numChannels, chunkSize);
+    juce::Random random(0x5eed);
+    auto numFrames = (juce::int64) (seconds * sampleRate);
+
+    // a tone with a little noise, the same every run
+    for (juce::int64 start = 0; start < numFrames; start += chunkSize) {
+        auto numSamples = (int) juce::jmin((juce::int64) chunkSize, numFrames - start);
+
+        for (int i = 0; i < numSamples; ++i) {
+            auto phase = juce::MathConstants<double>::twoPi * 220.0 * (double) (start + i) / sampleRate;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                chunk.setSample(ch, i, 0.5f * (float) std::sin(phase + ch) + 0.05f * (random.nextFloat() * 2.0f - 1.0f));
+        }
+
+        writer->writeFromAudioSampleBuffer(chunk, 0, numSamples);
+    }
+
+    return file;
+}
+
+//==============================================================================
+juce::var BenchmarkSuite::toJson(const std::vector<Measurement>& measurements)
+{
+    juce::Array<juce::var> list;
+
+    for (auto& measurement : measurements) {
+        auto settings = std::make_unique<juce::DynamicObject>();
+
+        for (auto& setting : measurement.settings)
+            settings->setProperty(setting.name, setting.value);
+
+        auto object = std::make_unique<juce::DynamicObject>();
+        object->setProperty("name", measurement.name);
+        object->setProperty("settings", settings.release());
+        object->setProperty("value", measurement.value);
+        object->setProperty("unit", measurement.unit);
+        list.add(object.release());
+    }
+
+    return list;
+}
+
+std::vector<BenchmarkSuite::Measurement> BenchmarkSuite::fromJson(const juce::var& json)
+{
+    std::vector<Measurement> measurements;
+
+    if (auto* list = json.getArray()) {
+        for (auto& item : *list) {
+            Measurement measurement;
+            measurement.name = item["name"].toString();
+            measurement.value = (double) item["value"];
+            measurement.unit = item["unit"].toString();
+
+            if (auto* settings = item["settings"].getDynamicObject())
+                measurement.settings = settings->getProperties();
+
+            measurements.push_back(std::move(measurement));
+        }
+    }
+
+    return measurements;
+}
+
+int BenchmarkSuite::compare(const std::vector<Measurement>& baseline, const std::vector<Measurement>& current,
+                            double tolerance, juce::StringArray& report)
+{
+    std::map<juce::String, double> baselineValues;
+
+    for (auto& measurement : baseline)
+        baselineValues[measurement.getKey()] = measurement.value;
+
+    int numRegressions = 0;
+
+    // everything measured is a cost, higher is worse
+    for (auto& measurement : current) {
+        auto found = baselineValues.find(measurement.getKey());
+
+        if (found == baselineValues.end() || found->second <= 0.0)
+            continue;
+
+        auto change = measurement.value / found->second - 1.0;
+        auto isRegression = change > tolerance;
+
+        if (isRegression)
+            ++numRegressions;
+
+        report.add(measurement.getKey() + ": " + juce::String(found->second, 3) + " -> " + juce::String(measurement.value, 3)
+                   + " " + measurement.unit + " (" + (change >= 0.0 ? "+" : "") + juce::String(change * 100.0, 1) + "%)"
+                   + (isRegression ? "  REGRESSION" : ""));
+    }
+
+    return numRegressions;
+}
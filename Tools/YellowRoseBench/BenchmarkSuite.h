@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    BenchmarkSuite.h
+    Created: 15 Feb 2025 11:02:44am
+    Author:  Michael
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Times the audio path, sample loading and the thumbnail on generated material.
+    The test files, the notes and the settings come from fixed seeds and tables,
+    so two runs only differ by how fast the machine ran them. Every time is the
+    best of a few runs.
+
+    The results go out as JSON. A later run can be compared against them, and
+    anything slower by more than the tolerance counts as a regression.
+*/
+class BenchmarkSuite
+{
+public:
+    struct Measurement
+    {
+        juce::String name;
+        juce::NamedValueSet settings;
+        double value{ 0.0 };
+        juce::String unit;
+
+        /** The name and settings, the same for the same measurement in any run. */
+        juce::String getKey() const;
+    };
+
+    struct Options
+    {
+        /** Shorter renders and fewer configurations, for a quick look. */
+        bool quick{ false };
+        int numRuns{ 3 };
+
+        /** Called with a line of progress from the thread running the suite. */
+        std::function<void(const juce::String&)> log;
+    };
+
+    BenchmarkSuite(const Options& options);
+    ~BenchmarkSuite();
+
+    void runProcessBlock();
+
+    /** processBlock at 64 and 128 voices, with and without the VoiceBank. */
+    void runVoiceBank();
+    void runFilter();
+    void runEnvelopeUpdates();
+    void runLoading();
+    void runPainting();
+    void runMidiScheduling();
+
+    void runAll();
+
+    const std::vector<Measurement>& getMeasurements() const { return mMeasurements; }
+
+    //==============================================================================
+    static juce::var toJson(const std::vector<Measurement>& measurements);
+    static std::vector<Measurement> fromJson(const juce::var& json);
+
+    /** Lines for every measurement found in both, marking those that got slower than
+        tolerance allows. Returns the number of regressions.
+    */
+    static int compare(const std::vector<Measurement>& baseline, const std::vector<Measurement>& current,
+                       double tolerance, juce::StringArray& report);
+
+private:
+    void add(const juce::String& name, juce::NamedValueSet settings, double value, const juce::String& unit);
+    void log(const juce::String& line) const;
+
+    juce::File writeTestFile(juce::AudioFormat& format, const juce::String& name, double seconds,
+                             double sampleRate, int numChannels);
+
+    Options mOptions;
+    juce::File mDirectory;
+    juce::AudioFormatManager mFormatManager;
+    std::vector<Measurement> mMeasurements;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BenchmarkSuite)
+};
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 15 Feb 2025 2:36:58pm
+    Author:  Michael
+
+    Benchmark runner: times the audio path, loading and painting, writes the
+    results as JSON and compares them with an earlier run.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "BenchmarkSuite.h"
+
+namespace
+{
+    juce::var describeMachine()
+    {
+        auto machine = std::make_unique<juce::DynamicObject>();
+        machine->setProperty("cpu", juce::SystemStats::getCpuModel());
+        machine->setProperty("cores", juce::SystemStats::getNumPhysicalCpus());
+        machine->setProperty("threads", juce::SystemStats::getNumCpus());
+        machine->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        machine->setProperty("juce", juce::SystemStats::getJUCEVersion());
+        return machine.release();
+    }
+
+    int run(const juce::ArgumentList& args)
+    {
+        BenchmarkSuite::Options options;
+        options.quick = args.containsOption("--quick");
+        options.log = [](const juce::String& line) { std::cout << line << std::endl; };
+
+        if (args.containsOption("--runs"))
+            options.numRuns = juce::jmax(1, args.getValueForOption("--runs").getIntValue());
+
+        BenchmarkSuite suite(options);
+
+        // all of them unless some are picked
+        juce::StringArray only;
+
+        if (args.containsOption("--only"))
+            only.addTokens(args.getValueForOption("--only"), ",", {});
+
+        auto wanted = [&only](const char* name) { return only.isEmpty() || only.contains(name); };
+
+        if (wanted("process"))  suite.runProcessBlock();
+        if (wanted("bank"))     suite.runVoiceBank();
+        if (wanted("filter"))   suite.runFilter();
+        if (wanted("envelope")) suite.runEnvelopeUpdates();
+        if (wanted("load"))     suite.runLoading();
+        if (wanted("paint"))    suite.runPainting();
+        if (wanted("midi"))     suite.runMidiScheduling();
+
+        if (args.containsOption("--json")) {
+            auto results = std::make_unique<juce::DynamicObject>();
+            results->setProperty("version", 1);
+            results->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+            results->setProperty("quick", options.quick);
+            results->setProperty("machine", describeMachine());
+            results->setProperty("measurements", BenchmarkSuite::toJson(suite.getMeasurements()));
+
+            auto file = args.getFileForOption("--json");
+
+            if (!file.replaceWithText(juce::JSON::toString(juce::var(results.release()))))
+                juce::ConsoleApplication::fail("Can't write " + file.getFullPathName());
+        }
+
+        if (args.containsOption("--compare")) {
+            auto baseline = juce::JSON::parse(args.getExistingFileForOption("--compare"));
+            auto tolerance = args.containsOption("--tolerance") ? args.getValueForOption("--tolerance").getDoubleValue() : 0.1;
+
+            juce::StringArray report;
+            auto numRegressions = BenchmarkSuite::compare(BenchmarkSuite::fromJson(baseline["measurements"]),
+                                                          suite.getMeasurements(), tolerance, report);
+
+            std::cout << std::endl << report.joinIntoString("\n") << std::endl;
+
+            // for the release checks, a regression fails the run
+            if (numRegressions > 0)
+                juce::ConsoleApplication::fail(juce::String(numRegressions) + " measurements got more than "
+                                               + juce::String(tolerance * 100.0, 0) + "% slower");
+        }
+
+        return 0;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // the processor, the thumbnail and its fonts expect a message manager
+    juce::ScopedJuceInitialiser_GUI juce;
+
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h")) {
+        std::cout << "YellowRoseBench [options]\n"
+                     "  --quick               fewer configurations and shorter renders\n"
+                     "  --runs <n>            runs per measurement, the best counts, 3 by default\n"
+                     "  --only <a,b,...>      process, bank, filter, envelope, load, paint and/or midi\n"
+                     "  --json <file>         writes the results\n"
+                     "  --compare <file>      compares with results written earlier\n"
+                     "  --tolerance <ratio>   slowdown that counts as a regression, 0.1 by default\n";
+        return 0;
+    }
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&args] { return run(args); });
+}
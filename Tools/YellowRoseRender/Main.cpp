@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 8 Feb 2025 5:21:10pm
+    Author:  Michael
+
+    Console renderer: bounces MIDI files through YellowRose into WAV files,
+    one at a time or a whole list of them across the cores.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../Source/OfflineRenderer.h"
+
+namespace
+{
+    OfflineRenderer::Settings readSettings(const juce::ArgumentList& args)
+    {
+        OfflineRenderer::Settings settings;
+
+        if (args.containsOption("--rate"))
+            settings.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+
+        if (args.containsOption("--block"))
+            settings.blockSize = args.getValueForOption("--block").getIntValue();
+
+        if (args.containsOption("--tail"))
+            settings.tailSeconds = args.getValueForOption("--tail").getDoubleValue();
+
+        if (args.containsOption("--bits"))
+            settings.bitDepth = args.getValueForOption("--bits").getIntValue();
+
+        if (settings.sampleRate < 8000.0 || settings.sampleRate > 384000.0)
+            juce::ConsoleApplication::fail("The rate has to be between 8000 and 384000");
+
+        if (settings.blockSize < 16 || settings.blockSize > 8192)
+            juce::ConsoleApplication::fail("The block size has to be between 16 and 8192");
+
+        if (settings.bitDepth != 16 && settings.bitDepth != 24 && settings.bitDepth != 32)
+            juce::ConsoleApplication::fail("The bit depth has to be 16, 24 or 32");
+
+        // --set ID=value, as many as needed
+        for (int i = 0; i + 1 < args.size(); ++i) {
+            if (args[i] == "--set") {
+                auto assignment = args[i + 1].text;
+                settings.parameters.set(assignment.upToFirstOccurrenceOf("=", false, false).trim(),
+                                        assignment.fromFirstOccurrenceOf("=", false, false).trim());
+            }
+        }
+
+        return settings;
+    }
+
+    juce::File getOptionalFile(const juce::ArgumentList& args, const juce::String& option)
+    {
+        return args.containsOption(option) ? args.getExistingFileForOption(option) : juce::File();
+    }
+
+    void report(const std::vector<OfflineRenderer::Job>& jobs, const std::vector<OfflineRenderer::Outcome>& outcomes)
+    {
+        int numFailed = 0;
+
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            auto& outcome = outcomes[i];
+            auto name = jobs[i].output.getFileName();
+
+            if (outcome.result.failed()) {
+                std::cerr << name << ": " << outcome.result.getErrorMessage() << std::endl;
+                ++numFailed;
+                continue;
+            }
+
+            std::cout << name << ": " << juce::String(outcome.audioSeconds, 1) << " s in "
+                      << juce::String(outcome.renderSeconds, 2) << " s, "
+                      << juce::String(outcome.getSpeed(), 1) << "x real time" << std::endl;
+        }
+
+        if (numFailed > 0)
+            juce::ConsoleApplication::fail(juce::String(numFailed) + " of " + juce::String((int) jobs.size()) + " renders failed");
+    }
+
+    void render(const juce::ArgumentList& args)
+    {
+        OfflineRenderer::Job job;
+        job.sample = getOptionalFile(args, "--sample");
+        job.state = getOptionalFile(args, "--state");
+        job.midi = args.getExistingFileForOption("--midi");
+        job.output = args.getFileForOption("--out");
+
+        std::vector<OfflineRenderer::Job> jobs{ job };
+        report(jobs, { OfflineRenderer::render(job, readSettings(args)) });
+    }
+
+    // one job per line: sample, MIDI file and output, paths with spaces in quotes
+    std::vector<OfflineRenderer::Job> readJobList(const juce::File& list, const juce::File& state)
+    {
+        std::vector<OfflineRenderer::Job> jobs;
+        juce::StringArray lines;
+        list.readLines(lines);
+
+        for (auto& line : lines) {
+            if (line.trim().isEmpty() || line.trimStart().startsWithChar('#'))
+                continue;
+
+            juce::StringArray fields;
+            fields.addTokens(line, " \t", "\"");
+            fields.removeEmptyStrings();
+            fields.trim();
+
+            if (fields.size() != 3)
+                juce::ConsoleApplication::fail("Expected a sample, a MIDI file and an output in: " + line);
+
+            auto resolve = [&list](const juce::String& path) {
+                return list.getParentDirectory().getChildFile(path.unquoted());
+            };
+
+            jobs.push_back({ resolve(fields[0]), state, resolve(fields[1]), resolve(fields[2]) });
+        }
+
+        return jobs;
+    }
+
+    void batch(const juce::ArgumentList& args)
+    {
+        args.checkMinNumArguments(2);
+
+        auto jobs = readJobList(args[1].resolveAsExistingFile(), getOptionalFile(args, "--state"));
+        auto numThreads = juce::SystemStats::getNumCpus();
+
+        if (args.containsOption("--jobs"))
+            numThreads = juce::jmax(1, args.getValueForOption("--jobs").getIntValue());
+
+        auto start = juce::Time::getMillisecondCounterHiRes();
+        auto outcomes = OfflineRenderer::renderAll(jobs, readSettings(args), numThreads);
+
+        std::cout << jobs.size() << " renders on " << numThreads << " threads in "
+                  << juce::String((juce::Time::getMillisecondCounterHiRes() - start) / 1000.0, 2) << " s" << std::endl;
+
+        report(jobs, outcomes);
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // the processor's parameters and loader expect a message manager to exist
+    juce::ScopedJuceInitialiser_GUI juce;
+
+    const juce::String options = "  --rate <hz>       sample rate, 48000 by default\n"
+                                 "  --block <frames>  block size, 512 by default\n"
+                                 "  --tail <seconds>  rendered after the last event, 2 by default\n"
+                                 "  --bits <16|24|32> WAV bit depth, 24 by default, 32 is float\n"
+                                 "  --state <file>    a state saved by the plugin\n"
+                                 "  --set <ID=value>  sets a parameter, in its own units\n";
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "YellowRoseRender, offline renders of YellowRose", true);
+    app.addVersionCommand("--version", "YellowRoseRender " JucePlugin_VersionString);
+
+    app.addCommand({ "render",
+                     "render --midi <file> --out <file.wav> [--sample <file>] [options]",
+                     "Renders one MIDI file",
+                     "Plays the MIDI file through a sample or an SFZ instrument and writes a stereo WAV file.\n"
+                     "Options:\n" + options,
+                     render });
+
+    app.addCommand({ "batch",
+                     "batch <list> [--jobs <n>] [options]",
+                     "Renders a list of MIDI files in parallel",
+                     "Every line of the list is a sample, a MIDI file and an output, paths relative to the list.\n"
+                     "Runs --jobs renders at a time, one per core by default.\n"
+                     "Options:\n" + options,
+                     batch });
+
+    return app.findAndRunCommand(argc, argv);
+}